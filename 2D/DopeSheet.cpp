@@ -1,16 +1,98 @@
 #include "DopeSheet.h"
+#include <algorithm>
+#include <cmath>
 
 namespace Animation
 {
-  DopeSheet2D::DopeSheet2D() : sheetDuration{ .0f }, sheetRate{60.f}
+  DopeSheet2D::DetailedTrack::DetailedTrack(AssetArena* arena)
   {
+    for (auto& attributeTrack : attributeTracks)
+    {
+      attributeTrack = ArenaVector<DetailedKeyframe>(ArenaAllocator<DetailedKeyframe>(arena));
+    }
+  }
+
+  DopeSheet2D::DopeSheet2D(AssetArena* arena) : detailedSheet{ arena }, sheetDuration{ .0f }, sheetRate{60.f}
+  {
+    detailedSheet.setStatsName("DopeSheet2D tracks");
+  }
+
+  void DopeSheet2D::CompressionReport::merge(const CompressionReport& other)
+  {
+    keysIn += other.keysIn;
+    keysOut += other.keysOut;
+    bytesIn += other.bytesIn;
+    bytesOut += other.bytesOut;
+    maxTranslationError = std::max(maxTranslationError, other.maxTranslationError);
+    maxRotationError = std::max(maxRotationError, other.maxRotationError);
+    maxScaleError = std::max(maxScaleError, other.maxScaleError);
+  }
+
+  void DopeSheet2D::ResampleReport::merge(const ResampleReport& other)
+  {
+    maxTranslationError = std::max(maxTranslationError, other.maxTranslationError);
+    maxRotationError = std::max(maxRotationError, other.maxRotationError);
+    maxScaleError = std::max(maxScaleError, other.maxScaleError);
+    samples += other.samples;
+    bytes += other.bytes;
   }
 
-  DopeSheet2D::BakedTrack* DopeSheet2D::bakeTrack(const DetailedTrack& track) const
+  const DopeSheet2D::BakedTrack* DopeSheet2D::bakeTrack(const DetailedTrack& track, AssetArena& arena, const BakeSettings& settings, ResampleReport* resampleReport, CompressionReport* compressionReport) const
   {
-    BakedTrack* out = new BakedTrack();
+    // A one bone animation, so there is a single bake path to maintain. Its small header rides along in the arena
+    BlockWriter block;
+    const DetailedTrack* tracks[] = { &track };
+    const size_t animationOffset = writeAnimation(tracks, 1, block, settings, resampleReport, compressionReport);
+    if (!block.at<BakedAnimation>(animationOffset).getTrack(0)) { return nullptr; } // No keys, nothing worth keeping
+    return reinterpret_cast<const BakedAnimation*>(static_cast<const Byte*>(block.copyTo(arena)) + animationOffset)->getTrack(0);
+  }
+
+  size_t DopeSheet2D::writeAnimation(const DetailedTrack* const* tracks, size_t trackCount, BlockWriter& block, const BakeSettings& settings, ResampleReport* resampleReport, CompressionReport* compressionReport) const
+  {
+    if (resampleReport) { *resampleReport = {}; }
+    if (compressionReport) { *compressionReport = {}; }
+
+    // Track offsets are taken from the header, so the animation stays whole wherever the block ends up
+    const size_t animationOffset = block.claim<BakedAnimation>();
+    const size_t trackOffsets = block.claim<UInt>(trackCount);
+    block.link(block.at<BakedAnimation>(animationOffset).trackOffsets, trackOffsets, trackCount);
+    for (size_t trackID = 0; trackID < trackCount; ++trackID)
+    {
+      if (!tracks[trackID]) { continue; }
+
+      const size_t trackOffset = writeTrack(*tracks[trackID], block, settings, resampleReport, compressionReport);
+      if (trackOffset != SNULL) { block.at<UInt>(trackOffsets + trackID * sizeof(UInt)) = static_cast<UInt>(trackOffset - animationOffset); }
+    }
+
+    block.at<BakedAnimation>(animationOffset).byteSize = static_cast<UInt>(block.getSize() - animationOffset);
+    return animationOffset;
+  }
+
+  size_t DopeSheet2D::writeTrack(const DetailedTrack& track, BlockWriter& block, const BakeSettings& settings, ResampleReport* resampleReport, CompressionReport* compressionReport) const
+  {
+    typedef BakedTrack::SubTrack SubTrack;
+
+    // Skip unused tracks before claiming any memory
+    size_t usedCount = 0;
+    for (auto& subTrack : track.attributeTracks) { usedCount += subTrack.empty() ? 0 : 1; }
+    if (!usedCount) { return SNULL; }
+
+    // Headers first, then the keys of each subtrack in turn. References into the block are refetched after every claim
+    const size_t trackOffset = block.claim<BakedTrack>();
+    const size_t subTracksOffset = block.claim<SubTrack>(usedCount);
+    block.link(block.at<BakedTrack>(trackOffset).subTracks, subTracksOffset, usedCount);
+    auto getBaked = [&]() -> BakedTrack& { return block.at<BakedTrack>(trackOffset); };
+    auto getSubTrack = [&](size_t subID) -> SubTrack& { return block.at<SubTrack>(subTracksOffset + subID * sizeof(SubTrack)); };
+
+    // Keys are gathered outside the block, so only what survives compression is ever stored there
+    std::vector<Keyframe> keys;
+    std::vector<float> keyTimes;
+    std::vector<UShort> keyValues;
+    std::vector<std::vector<Keyframe>> originals(compressionReport ? usedCount : 0); // Keys before compression, to measure against
+    CompressionReport compressed = {};
 
     // Bake the track for each attribute
+    size_t subID = 0;
     for (Byte attributeID = 0; attributeID < AttributeType::AttributeCount; ++attributeID)
     {
       auto& subTrack = track.attributeTracks[attributeID];
@@ -18,9 +100,8 @@ namespace Animation
       if (subTrack.size())
       {
         // This track is in use, start build
-        out->subTracks.emplace_back();
-        auto& subProgress = out->subTracks.back();
-        
+        auto& subProgress = getSubTrack(subID);
+
         // Set attribute flags
         switch (attribType)
         {
@@ -44,21 +125,36 @@ namespace Animation
         }
 
         float durationProgress = .0f;
+        keys.clear();
         for (auto& unrefinedKey : subTrack)
         {
           // Start to build the key
-          subProgress.keyframes.emplace_back();
-          auto& freshKey = subProgress.keyframes.back();
+          keys.emplace_back();
+          auto& freshKey = keys.back();
           freshKey.startTime = durationProgress;
           freshKey.easeIn = unrefinedKey.easeIn;
           freshKey.easeOut = unrefinedKey.easeOut;
 
-          // Build and apply a transformation matrix for this key according to its type
+          // Build and apply a transformation matrix for this key according to its type. Components an attribute does
+          // not set stay at rest, so single axis keys still interpolate as pairs
+          freshKey.transform.translation = gef::Vector2::kZero;
+          freshKey.transform.scale = gef::Vector2::kOne;
+          freshKey.transform.rotation = .0f;
           switch (attribType)
           {
-            case AttributeTranslation:
+            case AttributeScale:
             {
-              freshKey.transform.translation = gef::Vector2(unrefinedKey.values[0], unrefinedKey.values[1]);
+              freshKey.transform.scale = gef::Vector2(unrefinedKey.values[0], unrefinedKey.values[1]);
+            }
+            break;
+            case AttributeWidth:
+            {
+              freshKey.transform.scale.x = unrefinedKey.values[0];
+            }
+            break;
+            case AttributeHeight:
+            {
+              freshKey.transform.scale.y = unrefinedKey.values[0];
             }
             break;
             case AttributeRotation:
@@ -66,36 +162,104 @@ namespace Animation
               freshKey.transform.rotation = unrefinedKey.values[0];
             }
             break;
-            default: throw; // TODO: implement
+            case AttributeTranslation:
+            {
+              freshKey.transform.translation = gef::Vector2(unrefinedKey.values[0], unrefinedKey.values[1]);
+            }
+            break;
+            case AttributeX:
+            {
+              freshKey.transform.translation.x = unrefinedKey.values[0];
+            }
+            break;
+            case AttributeY:
+            {
+              freshKey.transform.translation.y = unrefinedKey.values[0];
+            }
+            break;
+            default: break; // Full keys do not fit in MaxKeyValues and have no way in, see addBaseKeyframe
           }
 
           durationProgress += unrefinedKey.duration;
         }
 
         // We cannot have just 'one' key. One key implies a rest position therefore create an additional dummy!
-        if (subProgress.keyframes.size() <= 1)
+        if (keys.size() <= 1)
         {
-          subProgress.keyframes.push_back(subProgress.keyframes.back());
-          subProgress.keyframes.back().startTime = durationProgress;
+          keys.push_back(keys.back());
+          keys.back().startTime = durationProgress;
         }
+
+        if (compressionReport) { originals[subID] = keys; }
+        BakedTrack::reduceKeys(subProgress, keys, settings);
+
+        keyTimes.clear();
+        for (auto& key : keys) { keyTimes.push_back(key.startTime); }
+        const size_t timesOffset = block.append(keyTimes.data(), keyTimes.size());
+        block.link(getSubTrack(subID).keyTimes, timesOffset, keyTimes.size());
+
+        Byte components[BakedTrack::ComponentCount];
+        const Byte liveCount = BakedTrack::getLiveComponents(getSubTrack(subID), components);
+        if (!settings.quantize)
+        {
+          const size_t keysOffset = block.append(keys.data(), keys.size());
+          block.link(getSubTrack(subID).keyframes, keysOffset, keys.size());
+        }
+        else
+        {
+          BakedTrack::quantizeKeys(getSubTrack(subID), keys, keyValues);
+          const size_t valuesOffset = block.append(keyValues.data(), keyValues.size());
+          block.link(getSubTrack(subID).keyValues, valuesOffset, keyValues.size());
+        }
+
+        if (compressionReport)
+        {
+          compressed.keysIn += originals[subID].size();
+          compressed.keysOut += keys.size();
+          compressed.bytesIn += originals[subID].size() * sizeof(Keyframe);
+          compressed.bytesOut += settings.quantize ? keys.size() * (sizeof(float) + liveCount * sizeof(UShort)) : keys.size() * sizeof(Keyframe);
+        }
+        ++subID;
       }
     }
 
-    if (!out->getAttributeTrackCount())
+    // Measure what playback now gives at every original key
+    if (compressionReport)
+    {
+      for (subID = 0; subID < usedCount; ++subID) { getBaked().measureCompression(subID, originals[subID], compressed); }
+      compressionReport->merge(compressed);
+    }
+
+    if (settings.samplesPerFrame > .0f)
     {
-      delete out;
-      return nullptr;
+      // Columns follow the keys, so a resampled track still reads front to back
+      std::array<std::vector<float>, BakedTrack::ComponentCount> columns;
+      float samplesPerTime;
+      getBaked().resample(settings.samplesPerFrame, columns, samplesPerTime);
+      for (Byte component = 0; component < BakedTrack::ComponentCount; ++component)
+      {
+        const size_t columnOffset = block.append(columns[component].data(), columns[component].size());
+        block.link(getBaked().curve.columns[component], columnOffset, columns[component].size());
+      }
+      getBaked().curve.samplesPerTime = samplesPerTime;
+
+      if (resampleReport)
+      {
+        ResampleReport resampled;
+        getBaked().measureResample(resampled);
+        resampleReport->merge(resampled);
+      }
     }
 
-    return out;
+    return trackOffset;
   }
 
   void DopeSheet2D::inspectTracks(const std::function<void(gef::StringId, const DetailedTrack&)>& itFunc)
   {
-    for (auto& trackIt : detailedSheet.getNameMap())
+    detailedSheet.inspectNames([&](gef::StringId nameID, const NamedHeapInfo& indexer)
     {
-      itFunc(trackIt.first, detailedSheet.get(trackIt.second.getHeapID())); // Reflect the track
-    }
+      itFunc(nameID, detailedSheet.get(indexer.getHeapID())); // Reflect the track
+    });
   }
 
   DopeSheet2D::DetailedTrack& DopeSheet2D::getTrack(Label name)
@@ -109,15 +273,13 @@ namespace Animation
   }
   void DopeSheet2D::addBaseKeyframe(DetailedTrack& track, float duration, const std::initializer_list<float>& params, AttributeType keyType, const TweenPoint& in, const TweenPoint& out)
   {
-    track.attributeTracks[keyType].push_back({
-      params,
-      in,
-      out,
-      duration
-    });
+    if (keyType == AttributeFull || keyType >= AttributeCount) { return; } // Not packable into a key's values
+    DetailedKeyframe key = { {}, in, out, duration };
+    std::copy_n(params.begin(), std::min(params.size(), MaxKeyValues), key.values.begin());
+    track.attributeTracks[keyType].push_back(key);
   }
 
-  Maths::Transform2D DopeSheet2D::BakedTrack::applyTransform(float relativeTime, const Keyframe& first, const Keyframe& next, UInt subtrack)
+  Maths::Transform2D DopeSheet2D::BakedTrack::applyTransform(float relativeTime, const Keyframe& first, const Keyframe& next, UInt subtrack) const
   {
     const SubTrack& track = subTracks[subtrack];
 
@@ -135,17 +297,264 @@ namespace Animation
     return transform;
   }
 
-  float DopeSheet2D::BakedTrack::lerp(float a, float b, float t) const
+  Maths::Transform2D DopeSheet2D::BakedTrack::evaluate(float time) const
+  {
+    Maths::Transform2D transform;
+    transform.scale = gef::Vector2::kOne;
+    transform.rotation = .0f;
+    transform.translation = gef::Vector2::kZero;
+
+    for (size_t subID = 0; subID < subTracks.size(); ++subID)
+    {
+      transform = transform + evaluateSubtrack(subID, time);
+    }
+    return transform;
+  }
+
+  Maths::Transform2D DopeSheet2D::BakedTrack::evaluateSubtrack(size_t subtrack, float time) const
+  {
+    size_t keyID = findKey(subtrack, time, 0);
+    Keyframe currentScratch, nextScratch;
+    return applyTransform(time, getKey(subtrack, keyID, currentScratch), getKey(subtrack, keyID + 1, nextScratch), static_cast<UInt>(subtrack));
+  }
+
+  const DopeSheet2D::Keyframe& DopeSheet2D::BakedTrack::getKey(size_t subtrack, size_t idx, Keyframe& scratch) const
+  {
+    const SubTrack& track = subTracks[subtrack];
+    if (!track.keyframes.empty()) { return track.keyframes[idx]; }
+
+    // Quantized keys keep only their start time and live components. Easing is not kept, as it is not applied yet
+    Keyframe& key = scratch;
+    key = Keyframe{};
+    key.startTime = track.keyTimes[idx];
+    Byte components[ComponentCount];
+    const Byte liveCount = getLiveComponents(track, components);
+    const UShort* values = track.keyValues.data() + idx * liveCount;
+    for (Byte i = 0; i < liveCount; ++i)
+    {
+      getComponent(key.transform, components[i]) = track.quantizeMin[components[i]] + float(values[i]) * track.quantizeStep[components[i]];
+    }
+    return key;
+  }
+
+  Byte DopeSheet2D::BakedTrack::getLiveComponents(const SubTrack& track, Byte* components)
+  {
+    Byte count = 0;
+    if (track.hasTranslation) { components[count++] = ComponentX; components[count++] = ComponentY; }
+    if (track.hasRotation) { components[count++] = ComponentRotation; }
+    if (track.hasScale) { components[count++] = ComponentScaleX; components[count++] = ComponentScaleY; }
+    return count;
+  }
+
+  float& DopeSheet2D::BakedTrack::getComponent(Maths::Transform2D& transform, Byte component)
+  {
+    switch (component)
+    {
+      case ComponentX: return transform.translation.x;
+      case ComponentY: return transform.translation.y;
+      case ComponentRotation: return transform.rotation;
+      case ComponentScaleX: return transform.scale.x;
+      default: return transform.scale.y;
+    }
+  }
+
+  bool DopeSheet2D::BakedTrack::isReproducible(const SubTrack& track, const Keyframe& first, const Keyframe& next, const Keyframe& key, const BakeSettings& settings)
+  {
+    const float norm = (key.startTime - first.startTime) / (next.startTime - first.startTime);
+    if (track.hasTranslation)
+    {
+      gef::Vector2 translation = lerp(first.transform.translation, next.transform.translation, norm);
+      if (std::abs(translation.x - key.transform.translation.x) > settings.translationTolerance ||
+          std::abs(translation.y - key.transform.translation.y) > settings.translationTolerance) { return false; }
+    }
+    if (track.hasRotation)
+    {
+      float rotation = slerp(first.transform.rotation, next.transform.rotation, norm);
+      if (std::abs(std::remainder(rotation - key.transform.rotation, float(MATHS_TAU))) > settings.rotationTolerance) { return false; }
+    }
+    if (track.hasScale)
+    {
+      gef::Vector2 scale = lerp(first.transform.scale, next.transform.scale, norm);
+      if (std::abs(scale.x - key.transform.scale.x) > settings.scaleTolerance ||
+          std::abs(scale.y - key.transform.scale.y) > settings.scaleTolerance) { return false; }
+    }
+    return true;
+  }
+
+  void DopeSheet2D::BakedTrack::reduceKeys(const SubTrack& track, std::vector<Keyframe>& keys, const BakeSettings& settings)
+  {
+    // Greedily stretch each segment until an interior key strays past tolerance, then keep the key before it.
+    // Only attributes the subtrack animates are tested, so a tolerance of zero on any of them keeps its keys
+    const bool reduce = (!track.hasTranslation || settings.translationTolerance > .0f) && (!track.hasRotation || settings.rotationTolerance > .0f) && (!track.hasScale || settings.scaleTolerance > .0f);
+    if (!reduce || keys.size() <= 2) { return; }
+
+    size_t kept = 1, anchor = 0;
+    for (size_t next = 2; next < keys.size(); ++next)
+    {
+      for (size_t k = anchor + 1; k < next; ++k)
+      {
+        if (!isReproducible(track, keys[anchor], keys[next], keys[k], settings))
+        {
+          anchor = next - 1;
+          keys[kept++] = keys[anchor];
+          break;
+        }
+      }
+    }
+    keys[kept++] = keys.back();
+    keys.resize(kept);
+  }
+
+  void DopeSheet2D::BakedTrack::quantizeKeys(SubTrack& track, std::vector<Keyframe>& keys, std::vector<UShort>& values)
+  {
+    Byte components[ComponentCount];
+    const Byte liveCount = getLiveComponents(track, components);
+    for (Byte i = 0; i < liveCount; ++i)
+    {
+      float minValue = getComponent(keys[0].transform, components[i]), maxValue = minValue;
+      for (auto& key : keys)
+      {
+        const float value = getComponent(key.transform, components[i]);
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+      }
+      track.quantizeMin[components[i]] = minValue;
+      track.quantizeStep[components[i]] = (maxValue - minValue) / 65535.f;
+    }
+
+    values.clear();
+    values.reserve(keys.size() * liveCount);
+    for (auto& key : keys)
+    {
+      for (Byte i = 0; i < liveCount; ++i)
+      {
+        const float step = track.quantizeStep[components[i]];
+        const float units = step > .0f ? (getComponent(key.transform, components[i]) - track.quantizeMin[components[i]]) / step : .0f;
+        values.push_back(static_cast<UShort>(std::min(std::max(units + .5f, .0f), 65535.f)));
+      }
+    }
+  }
+
+  void DopeSheet2D::BakedTrack::measureCompression(size_t subtrack, const std::vector<Keyframe>& original, CompressionReport& report) const
+  {
+    const SubTrack& track = subTracks[subtrack];
+    for (auto& key : original)
+    {
+      Maths::Transform2D value = evaluateSubtrack(subtrack, key.startTime);
+      if (track.hasTranslation)
+      {
+        report.maxTranslationError = std::max(report.maxTranslationError, std::max(std::abs(value.translation.x - key.transform.translation.x), std::abs(value.translation.y - key.transform.translation.y)));
+      }
+      if (track.hasRotation)
+      {
+        report.maxRotationError = std::max(report.maxRotationError, std::abs(std::remainder(value.rotation - key.transform.rotation, float(MATHS_TAU))));
+      }
+      if (track.hasScale)
+      {
+        report.maxScaleError = std::max(report.maxScaleError, std::max(std::abs(value.scale.x - key.transform.scale.x), std::abs(value.scale.y - key.transform.scale.y)));
+      }
+    }
+  }
+
+  Maths::Transform2D DopeSheet2D::BakedTrack::sample(float time) const
+  {
+    // Times past either end hold the end samples, as keyframe playback does
+    const auto& columns = curve.columns;
+    const size_t lastSegment = columns[ComponentRotation].size() - 2;
+    const float position = std::max(time * curve.samplesPerTime, .0f);
+    const size_t idx = std::min(static_cast<size_t>(position), lastSegment);
+    const float t = std::min(position - float(idx), 1.f);
+
+    Maths::Transform2D transform;
+    transform.translation = gef::Vector2(lerp(columns[ComponentX][idx], columns[ComponentX][idx + 1], t), lerp(columns[ComponentY][idx], columns[ComponentY][idx + 1], t));
+    transform.scale = gef::Vector2(lerp(columns[ComponentScaleX][idx], columns[ComponentScaleX][idx + 1], t), lerp(columns[ComponentScaleY][idx], columns[ComponentScaleY][idx + 1], t));
+    transform.rotation = lerp(columns[ComponentRotation][idx], columns[ComponentRotation][idx + 1], t);
+    return transform;
+  }
+
+  void DopeSheet2D::BakedTrack::resample(float samplesPerFrame, std::array<std::vector<float>, ComponentCount>& columns, float& samplesPerTime) const
+  {
+    // Cover the span of the longest subtrack with whole steps no longer than requested
+    float span = .0f;
+    for (auto& subTrack : subTracks) { span = std::max(span, subTrack.keyTimes.back()); }
+    const size_t steps = std::max(static_cast<size_t>(std::ceil(span * samplesPerFrame)), size_t(1));
+    const float step = span / float(steps);
+    samplesPerTime = span > .0f ? 1.f / step : .0f;
+
+    for (auto& column : columns) { column.resize(steps + 1); }
+    for (size_t i = 0; i <= steps; ++i)
+    {
+      Maths::Transform2D transform = evaluate(step * float(i));
+      columns[ComponentX][i] = transform.translation.x;
+      columns[ComponentY][i] = transform.translation.y;
+      columns[ComponentScaleX][i] = transform.scale.x;
+      columns[ComponentScaleY][i] = transform.scale.y;
+
+      // Keep within half a turn of the previous sample so lerping never goes the long way round
+      float rotation = transform.rotation;
+      if (i)
+      {
+        rotation -= float(MATHS_TAU) * std::round((rotation - columns[ComponentRotation][i - 1]) / float(MATHS_TAU));
+      }
+      columns[ComponentRotation][i] = rotation;
+    }
+  }
+
+  void DopeSheet2D::BakedTrack::measureResample(ResampleReport& report) const
+  {
+    // Compare against the keyframes at every key, where the curve bends, and at quarters between samples
+    const size_t samples = curve.columns[ComponentRotation].size();
+    const float step = curve.samplesPerTime > .0f ? 1.f / curve.samplesPerTime : .0f;
+    report = { .0f, .0f, .0f, samples, samples * ComponentCount * sizeof(float) };
+    auto measure = [&](float time)
+    {
+      Maths::Transform2D exact = evaluate(time), approx = sample(time);
+      float rotationError = std::remainder(exact.rotation - approx.rotation, float(MATHS_TAU));
+      report.maxTranslationError = std::max(report.maxTranslationError, std::max(std::abs(exact.translation.x - approx.translation.x), std::abs(exact.translation.y - approx.translation.y)));
+      report.maxRotationError = std::max(report.maxRotationError, std::abs(rotationError));
+      report.maxScaleError = std::max(report.maxScaleError, std::max(std::abs(exact.scale.x - approx.scale.x), std::abs(exact.scale.y - approx.scale.y)));
+    };
+    for (auto& subTrack : subTracks)
+    {
+      for (float keyTime : subTrack.keyTimes) { measure(keyTime); }
+    }
+    for (size_t i = 0; i + 1 < samples; ++i)
+    {
+      for (float quarter : { .25f, .5f, .75f }) { measure(step * (float(i) + quarter)); }
+    }
+  }
+
+  size_t DopeSheet2D::BakedTrack::findKey(size_t subtrack, float time, size_t hint) const
+  {
+    const auto& keyTimes = subTracks[subtrack].keyTimes;
+    const size_t lastSegment = keyTimes.size() - 2; // Baking guarantees two keys
+
+    // Usual case, playback has moved on a key or two from the hint
+    if (hint <= lastSegment && keyTimes[hint] <= time)
+    {
+      for (size_t walked = 0; walked < seekWalkLimit; ++walked, ++hint)
+      {
+        if (hint == lastSegment || keyTimes[hint + 1] > time) { return hint; }
+      }
+    }
+
+    // Large steps, scrubs and rewinds. The segment is the last key starting at or before time
+    auto it = std::upper_bound(keyTimes.begin(), keyTimes.end(), time);
+    size_t key = it == keyTimes.begin() ? 0 : static_cast<size_t>(it - keyTimes.begin()) - 1;
+    return std::min(key, lastSegment);
+  }
+
+  float DopeSheet2D::BakedTrack::lerp(float a, float b, float t)
   {
     return a * (1.f - t) + b * t;
   }
 
-  gef::Vector2 DopeSheet2D::BakedTrack::lerp(const gef::Vector2& a, const gef::Vector2& b, float t) const
+  gef::Vector2 DopeSheet2D::BakedTrack::lerp(const gef::Vector2& a, const gef::Vector2& b, float t)
   {
     return a * (1.f - t) + b * t;
   }
 
-  float DopeSheet2D::BakedTrack::slerp(float a, float b, float t) const
+  float DopeSheet2D::BakedTrack::slerp(float a, float b, float t)
   {
     float diff = b - a;
     float sign = copysignf(1.f, diff);
@@ -173,32 +582,25 @@ namespace Animation
     transform.translation = gef::Vector2::kZero;
 
     if (track.trackPtr == nullptr) { return transform; }
+    if (track.trackPtr->isResampled()) { return track.trackPtr->sample(scaledTime); }
 
     for (size_t subID = 0; subID < track.keyPointers.size(); ++subID)
     {
+      // Cursors are only hints, so any jump in time still lands on the right segment
       auto& currentKeyID = track.keyPointers[subID];
-      size_t nextKeyID = currentKeyID + 1;
-
-      // Key target
-      const DopeSheet2D::Keyframe* nextKey = &track.trackPtr->getKey(subID, nextKeyID);
-      
-      // Validate target key according to the current time
-      ++nextKeyID; // Next AGAIN
-      if (nextKey->startTime < scaledTime && nextKeyID < track.trackPtr->getKeyframeCount(subID))
-      {
-        ++currentKeyID;
-        nextKey = &track.trackPtr->getKey(subID, nextKeyID);
-      }
+      currentKeyID = track.trackPtr->findKey(subID, scaledTime, currentKeyID);
 
-      const DopeSheet2D::Keyframe* currentKey = &track.trackPtr->getKey(subID, currentKeyID);
+      DopeSheet2D::Keyframe currentScratch, nextScratch;
+      const DopeSheet2D::Keyframe& currentKey = track.trackPtr->getKey(subID, currentKeyID, currentScratch);
+      const DopeSheet2D::Keyframe& nextKey = track.trackPtr->getKey(subID, currentKeyID + 1, nextScratch);
 
-      transform = transform + track.trackPtr->applyTransform(scaledTime, *currentKey, *nextKey, subID);
+      transform = transform + track.trackPtr->applyTransform(scaledTime, currentKey, nextKey, subID);
     }
 
     return transform;
   }
 
-  void DopePlayer2D::setTrack(size_t idx, DopeSheet2D::BakedTrack* trackPtr)
+  void DopePlayer2D::setTrack(size_t idx, const DopeSheet2D::BakedTrack* trackPtr)
   {
     auto& tracker = tracks[idx];
     if (tracker.trackPtr = trackPtr)
@@ -215,15 +617,26 @@ namespace Animation
 
   void DopePlayer2D::update(float dt)
   {
-    if (!isPlaying()) { return; }
+    // Same as seek, an empty or unrated sheet has no time to wrap into
+    if (!isPlaying() || !sheet || sheet->getDuration() <= .0f || sheet->getRate() <= .0f) { return; }
 
     time += dt;
     scaledTime = time * sheet->getRate();
     if (scaledTime > sheet->getDuration())
     {
-      reset();
+      // Cursors past the loop point fall back to a search on their next sample
       scaledTime = fmodf(scaledTime, sheet->getDuration());
       time = scaledTime / sheet->getRate();
     }
   }
+
+  void DopePlayer2D::seek(float seconds)
+  {
+    // An empty or unrated sheet has no time to wrap into, and fmodf would only leave NaN behind
+    if (!sheet || sheet->getDuration() <= .0f || sheet->getRate() <= .0f) { return; }
+
+    scaledTime = fmodf(seconds * sheet->getRate(), sheet->getDuration());
+    if (scaledTime < .0f) { scaledTime += sheet->getDuration(); }
+    time = scaledTime / sheet->getRate();
+  }
 }
\ No newline at end of file
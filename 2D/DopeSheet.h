@@ -3,11 +3,11 @@
 #include <maths/vector2.h>
 #include <vector>
 #include <array>
-#include <list>
 #include <map>
 #include <functional>
 
 #include "Maths.h"
+#include "Arena.h"
 #include "DataStructures.h"
 #include "../Defs.h"
 
@@ -41,9 +41,11 @@ namespace Animation
       float tweenWeight = .0f;
     };
 
+    static constexpr size_t MaxKeyValues = 2; // Widest implemented attribute, a translation or scale pair
+
     struct DetailedKeyframe
     {
-      std::vector<float> values; // Pack of all values for the attribute type
+      std::array<float, MaxKeyValues> values; // Inline pack of values, the attribute type fixes how many are used
       TweenPoint easeIn;
       TweenPoint easeOut;
       float duration;
@@ -51,7 +53,45 @@ namespace Animation
 
     struct DetailedTrack
     {
-      std::array<std::list<DetailedKeyframe>, AttributeCount> attributeTracks;
+      typedef std::true_type uses_asset_arena;
+      explicit DetailedTrack(AssetArena* arena = nullptr);
+
+      std::array<ArenaVector<DetailedKeyframe>, AttributeCount> attributeTracks; // Keys of each attribute in time order, stored flat
+    };
+
+    // Optional lossy stages of a bake. Zeroed settings bake every key losslessly
+    struct BakeSettings
+    {
+      float samplesPerFrame; // Also resample uniformly at this rate, trading memory for accuracy
+      float translationTolerance; // Keys their neighbours reproduce within these are dropped. Zero keeps every key of that attribute
+      float rotationTolerance; // Radians
+      float scaleTolerance;
+      bool quantize; // Store key values as 16 bit steps across each subtrack's range
+    };
+
+    // Effect of key reduction and quantization, errors measured at every original key
+    struct CompressionReport
+    {
+      size_t keysIn, keysOut;
+      size_t bytesIn, bytesOut; // Key storage only
+      float maxTranslationError;
+      float maxRotationError;
+      float maxScaleError;
+
+      inline float getRatio() const { return bytesOut ? float(bytesIn) / float(bytesOut) : .0f; }
+      void merge(const CompressionReport& other); // Sums the counts and keeps the worst errors
+    };
+
+    // Accuracy and cost of a resampled track, errors measured against the keyframes at and between samples
+    struct ResampleReport
+    {
+      float maxTranslationError;
+      float maxRotationError; // Radians
+      float maxScaleError;
+      size_t samples;
+      size_t bytes;
+
+      void merge(const ResampleReport& other); // Sums the counts and keeps the worst errors
     };
 
     struct Keyframe
@@ -62,41 +102,114 @@ namespace Animation
       TweenPoint easeOut;
     };
 
+    // Baked keys of one bone. Only ever lives inside a block laid out by the sheet, with every array stored after it,
+    // so the whole block can be moved or copied as raw bytes
     class BakedTrack
     {
       friend DopeSheet2D;
       public:
 
-      Maths::Transform2D applyTransform(float relativeTime, const Keyframe& first, const Keyframe& next, UInt subtrack);
-      const Keyframe& getKey(size_t subtrack, size_t idx) const { return subTracks[subtrack].keyframes[idx]; }
+      Maths::Transform2D applyTransform(float relativeTime, const Keyframe& first, const Keyframe& next, UInt subtrack) const;
+      Maths::Transform2D evaluate(float time) const; // Every subtrack combined at a time, searching from the first key
+      Maths::Transform2D sample(float time) const; // Resampled tracks only. An index and one lerp, no cursor needed
+      inline bool isResampled() const { return !curve.columns[ComponentRotation].empty(); }
+      // Stored keys are returned in place. Quantized keys are decoded into scratch, which is what gets returned then
+      const Keyframe& getKey(size_t subtrack, size_t idx, Keyframe& scratch) const;
       inline size_t getAttributeTrackCount() const { return subTracks.size(); }
-      inline size_t getKeyframeCount(size_t track) const { return subTracks[track].keyframes.size(); }
+      inline size_t getKeyframeCount(size_t track) const { return subTracks[track].keyTimes.size(); }
+      inline float getKeyTime(size_t subtrack, size_t idx) const { return subTracks[subtrack].keyTimes[idx]; }
+      // The key starting the segment that holds time, clamped to the final segment. Walks forward from the hint
+      // for the usual small steps, otherwise binary searches the start times
+      size_t findKey(size_t subtrack, float time, size_t hint) const;
 
       private:
+      static constexpr size_t seekWalkLimit = 4; // Keys walked from the hint before falling back to a binary search
+
+      // Transform2D values in the order quantized keys and resampled columns store them
+      enum Component : Byte
+      {
+        ComponentX = 0,
+        ComponentY,
+        ComponentRotation,
+        ComponentScaleX,
+        ComponentScaleY,
+        ComponentCount
+      };
+
       struct SubTrack
       {
-        std::vector<Keyframe> keyframes;
-        bool hasRotation = false;
-        bool hasTranslation = false;
-        bool hasScale = false;
+        RelativeArray<float> keyTimes; // Start times, searched without touching key values
+        RelativeArray<Keyframe> keyframes; // Empty when quantized
+        RelativeArray<UShort> keyValues; // Quantized only, the live components of each key in turn
+        std::array<float, ComponentCount> quantizeMin;
+        std::array<float, ComponentCount> quantizeStep;
+        bool hasRotation;
+        bool hasTranslation;
+        bool hasScale;
+      };
+
+      static Byte getLiveComponents(const SubTrack& track, Byte* components); // Components the subtrack animates, returns the count
+      static float& getComponent(Maths::Transform2D& transform, Byte component);
+
+      // Drops keys their neighbours reproduce within the settings' tolerances
+      static void reduceKeys(const SubTrack& track, std::vector<Keyframe>& keys, const BakeSettings& settings);
+      static bool isReproducible(const SubTrack& track, const Keyframe& first, const Keyframe& next, const Keyframe& key, const BakeSettings& settings);
+      // Spreads 16 bits across the range each live component covers, setting the subtrack's range
+      static void quantizeKeys(SubTrack& track, std::vector<Keyframe>& keys, std::vector<UShort>& values);
+      Maths::Transform2D evaluateSubtrack(size_t subtrack, float time) const;
+      void measureCompression(size_t subtrack, const std::vector<Keyframe>& original, CompressionReport& report) const;
+
+      // Combined transform at uniform steps over the keyed span, one column per component
+      struct ResampledCurve
+      {
+        std::array<RelativeArray<float>, ComponentCount> columns; // Rotation is unwrapped, so neighbours lerp the short way
+        float samplesPerTime; // Inverse of the sample step
       };
 
-      float lerp(float a, float b, float t) const;
-      gef::Vector2 lerp(const gef::Vector2& a, const gef::Vector2& b, float t) const;
-      float slerp(float a, float b, float t) const;
+      void resample(float samplesPerFrame, std::array<std::vector<float>, ComponentCount>& columns, float& samplesPerTime) const;
+      void measureResample(ResampleReport& report) const;
+
+      static float lerp(float a, float b, float t);
+      static gef::Vector2 lerp(const gef::Vector2& a, const gef::Vector2& b, float t);
+      static float slerp(float a, float b, float t);
 
       // Different attributes can have different interpolations therefore cannot be merged into one track and must be
       // kept separate
-      std::vector<SubTrack> subTracks;
+      RelativeArray<SubTrack> subTracks;
+      ResampledCurve curve; // Empty unless baked with resampling
+    };
+
+    // One animation baked as a single block: this header, an offset per bone, then each bone's track and keys in bone
+    // order, so sampling a whole skeleton reads forward through memory. Holds no pointers, so it can be moved freely
+    class BakedAnimation
+    {
+      friend DopeSheet2D;
+      public:
+
+      inline size_t getTrackCount() const { return trackOffsets.size(); }
+      inline const BakedTrack* getTrack(size_t bone) const
+      { return trackOffsets[bone] ? reinterpret_cast<const BakedTrack*>(reinterpret_cast<const Byte*>(this) + trackOffsets[bone]) : nullptr; }
+      inline size_t getByteSize() const { return byteSize; }
+
+      private:
+      UInt byteSize; // Header included
+      RelativeArray<UInt> trackOffsets; // From the start of the block, zero where a bone has no track
     };
 
-    DopeSheet2D();
+    typedef std::true_type uses_asset_arena;
+    explicit DopeSheet2D(AssetArena* arena = nullptr); // Detailed tracks are allocated from the arena when given
 
-    BakedTrack* bakeTrack(const DetailedTrack& track) const; // Bakes a track to be ready for use
+    // Bakes a lone track to be ready for use, as one allocation owned by the arena. Never delete it. Reports are filled for the stages the settings enable.
+    // Shorthand for a one track writeAnimation, copied into the arena
+    const BakedTrack* bakeTrack(const DetailedTrack& track, AssetArena& arena, const BakeSettings& settings = BakeSettings(), ResampleReport* resampleReport = nullptr, CompressionReport* compressionReport = nullptr) const;
+    // Bakes a BakedAnimation onto the end of the block, one track per bone, any of which may be null. Returns its offset in the block.
+    // Reports cover every track
+    size_t writeAnimation(const DetailedTrack* const* tracks, size_t trackCount, BlockWriter& block, const BakeSettings& settings = BakeSettings(), ResampleReport* resampleReport = nullptr, CompressionReport* compressionReport = nullptr) const;
     void inspectTracks(const std::function<void(gef::StringId, const DetailedTrack&)>& itFunc); // Enables iteration of detailed tracks
     DetailedTrack& getTrack(Label name); // Finds or creates a track of name
     bool doesTrackExist(Label name) const;
 
+    inline void reserveKeyframes(DetailedTrack& track, AttributeType keyType, size_t count) { auto& keys = track.attributeTracks[keyType]; keys.reserve(keys.size() + count); }
     inline void addTranslationKeyframe(DetailedTrack& track, float duration, const gef::Vector2& offset, const TweenPoint& in = TweenPoint(), const TweenPoint& out = TweenPoint())
     { addBaseKeyframe(track, duration, {offset.x, offset.y}, AttributeTranslation, in, out); }
     inline void addRotationKeyframe(DetailedTrack& track, float duration, float angle, const TweenPoint& in = TweenPoint(), const TweenPoint& out = TweenPoint())
@@ -110,6 +223,8 @@ namespace Animation
     inline float getDuration() const { return sheetDuration; }
 
     private:
+    // Lays out a track and its keys at the end of the block, returning its offset or SNULL if it has no keys. Adds to the reports
+    size_t writeTrack(const DetailedTrack& track, BlockWriter& block, const BakeSettings& settings, ResampleReport* resampleReport, CompressionReport* compressionReport) const;
     void addBaseKeyframe(DetailedTrack& track, float duration, const std::initializer_list<float>& params, AttributeType keyType, const TweenPoint& in, const TweenPoint& out);
 
     NamedHeap<DetailedTrack> detailedSheet; // Sheet information prior to optimisation
@@ -127,16 +242,18 @@ namespace Animation
     inline void resizeTracks(size_t trackCount) { tracks.resize(trackCount); }
     inline void setPlaying(bool playState) { playing = playState; }
     void setSheet(DopeSheet2D* context) { sheet = context; }
-    void setTrack(size_t idx, DopeSheet2D::BakedTrack* track);
+    void setTrack(size_t idx, const DopeSheet2D::BakedTrack* track);
     void reset();
     void update(float dt);
+    void seek(float seconds); // Jumps to a time in the sheet, wrapped into its duration. Cursors resolve on the next sample
 
     inline bool isPlaying() const { return playing; }
+    inline float getTime() const { return time; }
 
     private:
     struct Tracker // Track and the current progress
     {
-      DopeSheet2D::BakedTrack* trackPtr;
+      const DopeSheet2D::BakedTrack* trackPtr;
       std::vector<size_t> keyPointers;
     };
 
@@ -0,0 +1,186 @@
+#include "2D/Kinematics2D.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KINEMATICS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Maths
+{
+  Affine2D buildLocalAffine(const PoseColumns& rest, const PoseColumns& pose, size_t bone)
+  {
+    const float rotation = rest.rotation[bone] + pose.rotation[bone];
+    const float sine = sinf(rotation), cosine = cosf(rotation);
+    return { cosine * pose.scaleX[bone], sine, -sine, cosine * pose.scaleY[bone], rest.translationX[bone] + pose.translationX[bone], rest.translationY[bone] + pose.translationY[bone] };
+  }
+
+#ifdef KINEMATICS_SSE
+  namespace
+  {
+    // Four affines split into one register per component
+    struct AffineLanes
+    {
+      __m128 m00, m01, m10, m11, m20, m21;
+    };
+
+    inline AffineLanes loadLanes(const Affine2D& a, const Affine2D& b, const Affine2D& c, const Affine2D& d)
+    {
+      AffineLanes lanes;
+
+      // The linear parts are four contiguous floats each, so a 4x4 transpose gives the columns
+      lanes.m00 = _mm_loadu_ps(&a.m00);
+      lanes.m01 = _mm_loadu_ps(&b.m00);
+      lanes.m10 = _mm_loadu_ps(&c.m00);
+      lanes.m11 = _mm_loadu_ps(&d.m00);
+      _MM_TRANSPOSE4_PS(lanes.m00, lanes.m01, lanes.m10, lanes.m11);
+
+      __m128 ab = _mm_unpacklo_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&a.m20)), _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&b.m20)));
+      __m128 cd = _mm_unpacklo_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&c.m20)), _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&d.m20)));
+      lanes.m20 = _mm_movelh_ps(ab, cd);
+      lanes.m21 = _mm_movehl_ps(cd, ab);
+      return lanes;
+    }
+
+    inline void storeLanes(AffineLanes lanes, Affine2D& a, Affine2D& b, Affine2D& c, Affine2D& d)
+    {
+      _MM_TRANSPOSE4_PS(lanes.m00, lanes.m01, lanes.m10, lanes.m11);
+      _mm_storeu_ps(&a.m00, lanes.m00);
+      _mm_storeu_ps(&b.m00, lanes.m01);
+      _mm_storeu_ps(&c.m00, lanes.m10);
+      _mm_storeu_ps(&d.m00, lanes.m11);
+
+      __m128 ab = _mm_unpacklo_ps(lanes.m20, lanes.m21);
+      __m128 cd = _mm_unpackhi_ps(lanes.m20, lanes.m21);
+      _mm_storel_pi(reinterpret_cast<__m64*>(&a.m20), ab);
+      _mm_storeh_pi(reinterpret_cast<__m64*>(&b.m20), ab);
+      _mm_storel_pi(reinterpret_cast<__m64*>(&c.m20), cd);
+      _mm_storeh_pi(reinterpret_cast<__m64*>(&d.m20), cd);
+    }
+
+    // Affine2D::operator* per lane
+    inline AffineLanes compose(const AffineLanes& local, const AffineLanes& parent)
+    {
+      AffineLanes global;
+      global.m00 = _mm_add_ps(_mm_mul_ps(local.m00, parent.m00), _mm_mul_ps(local.m01, parent.m10));
+      global.m01 = _mm_add_ps(_mm_mul_ps(local.m00, parent.m01), _mm_mul_ps(local.m01, parent.m11));
+      global.m10 = _mm_add_ps(_mm_mul_ps(local.m10, parent.m00), _mm_mul_ps(local.m11, parent.m10));
+      global.m11 = _mm_add_ps(_mm_mul_ps(local.m10, parent.m01), _mm_mul_ps(local.m11, parent.m11));
+      global.m20 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(local.m20, parent.m00), _mm_mul_ps(local.m21, parent.m10)), parent.m20);
+      global.m21 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(local.m20, parent.m01), _mm_mul_ps(local.m21, parent.m11)), parent.m21);
+      return global;
+    }
+
+    // Cephes style sine and cosine of four angles at once. Stays within a few ulp for angles of a few thousand radians
+    inline void sinCos(__m128 x, __m128& outSin, __m128& outCos)
+    {
+      // Reduce to [-pi/4, pi/4] around the nearest quarter turn, subtracting pi/2 in three parts to keep precision
+      __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772367581f)));
+      __m128 q = _mm_cvtepi32_ps(quadrant);
+      __m128 y = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+      y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+      y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(7.54978995489188216e-8f)));
+      __m128 y2 = _mm_mul_ps(y, y);
+
+      __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+      s = _mm_add_ps(_mm_mul_ps(s, y2), _mm_set1_ps(8.3321608736e-3f));
+      s = _mm_add_ps(_mm_mul_ps(s, y2), _mm_set1_ps(-1.6666654611e-1f));
+      s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, y2), y), y);
+
+      __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+      c = _mm_add_ps(_mm_mul_ps(c, y2), _mm_set1_ps(-1.388731625493765e-3f));
+      c = _mm_add_ps(_mm_mul_ps(c, y2), _mm_set1_ps(4.166664568298827e-2f));
+      c = _mm_mul_ps(_mm_mul_ps(c, y2), y2);
+      c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(y2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+      // Odd quadrants swap sine and cosine, then each picks up its sign from the quadrant
+      __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+      __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+      __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+      outSin = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sinSign);
+      outCos = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosSign);
+    }
+  }
+
+  void buildLocalAffines(const PoseColumns& rest, const PoseColumns& pose, Affine2D* locals, size_t paddedCount)
+  {
+    for (size_t i = 0; i < paddedCount; i += KinematicsWidth)
+    {
+      __m128 rotation = _mm_add_ps(_mm_loadu_ps(rest.rotation + i), _mm_loadu_ps(pose.rotation + i));
+      __m128 sine, cosine;
+      sinCos(rotation, sine, cosine);
+
+      AffineLanes lanes;
+      lanes.m00 = _mm_mul_ps(cosine, _mm_loadu_ps(pose.scaleX + i));
+      lanes.m01 = sine;
+      lanes.m10 = _mm_sub_ps(_mm_setzero_ps(), sine);
+      lanes.m11 = _mm_mul_ps(cosine, _mm_loadu_ps(pose.scaleY + i));
+      lanes.m20 = _mm_add_ps(_mm_loadu_ps(rest.translationX + i), _mm_loadu_ps(pose.translationX + i));
+      lanes.m21 = _mm_add_ps(_mm_loadu_ps(rest.translationY + i), _mm_loadu_ps(pose.translationY + i));
+      storeLanes(lanes, locals[i], locals[i + 1], locals[i + 2], locals[i + 3]);
+    }
+  }
+
+  void composeLevel(const UInt* bones, const UInt* parents, const Affine2D* locals, Affine2D* globals, size_t count)
+  {
+    size_t i = 0;
+    for (; i + KinematicsWidth <= count; i += KinematicsWidth)
+    {
+      const UInt b0 = bones[i], b1 = bones[i + 1], b2 = bones[i + 2], b3 = bones[i + 3];
+      AffineLanes local = loadLanes(locals[b0], locals[b1], locals[b2], locals[b3]);
+      AffineLanes parent = loadLanes(globals[parents[b0]], globals[parents[b1]], globals[parents[b2]], globals[parents[b3]]);
+
+      AffineLanes global = compose(local, parent);
+      storeLanes(global, globals[b0], globals[b1], globals[b2], globals[b3]);
+    }
+
+    // Remainder of the level
+    for (; i < count; ++i)
+    {
+      globals[bones[i]] = locals[bones[i]] * globals[parents[bones[i]]];
+    }
+  }
+
+  void composeAcross(UInt bone, UInt parent, const Affine2D* const* locals, Affine2D* const* globals, size_t count)
+  {
+    size_t i = 0;
+    for (; i + KinematicsWidth <= count; i += KinematicsWidth)
+    {
+      AffineLanes local = loadLanes(locals[i][bone], locals[i + 1][bone], locals[i + 2][bone], locals[i + 3][bone]);
+      AffineLanes parentLanes = loadLanes(globals[i][parent], globals[i + 1][parent], globals[i + 2][parent], globals[i + 3][parent]);
+
+      AffineLanes global = compose(local, parentLanes);
+      storeLanes(global, globals[i][bone], globals[i + 1][bone], globals[i + 2][bone], globals[i + 3][bone]);
+    }
+
+    for (; i < count; ++i)
+    {
+      globals[i][bone] = locals[i][bone] * globals[i][parent];
+    }
+  }
+#else
+  void buildLocalAffines(const PoseColumns& rest, const PoseColumns& pose, Affine2D* locals, size_t paddedCount)
+  {
+    for (size_t i = 0; i < paddedCount; ++i)
+    {
+      locals[i] = buildLocalAffine(rest, pose, i);
+    }
+  }
+
+  void composeLevel(const UInt* bones, const UInt* parents, const Affine2D* locals, Affine2D* globals, size_t count)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      globals[bones[i]] = locals[bones[i]] * globals[parents[bones[i]]];
+    }
+  }
+
+  void composeAcross(UInt bone, UInt parent, const Affine2D* const* locals, Affine2D* const* globals, size_t count)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      globals[i][bone] = locals[i][bone] * globals[i][parent];
+    }
+  }
+#endif
+}
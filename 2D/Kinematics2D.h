@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../Defs.h"
+#include "Maths.h"
+
+namespace Maths
+{
+  // Bones processed per SIMD step. Pose columns handed to buildLocalAffines are padded to a multiple of this
+  static constexpr size_t KinematicsWidth = 4;
+  inline size_t padToKinematicsWidth(size_t count) { return (count + KinematicsWidth - 1) / KinematicsWidth * KinematicsWidth; }
+
+  // Column-wise pose, one float per bone in each
+  struct PoseColumns
+  {
+    const float* translationX;
+    const float* translationY;
+    const float* rotation;
+    const float* scaleX; // Unused for rest poses, which are never scaled
+    const float* scaleY;
+  };
+
+  // Local affines of (rest + pose), matching Transform2D::operator+ followed by assignTo
+  Affine2D buildLocalAffine(const PoseColumns& rest, const PoseColumns& pose, size_t bone);
+  void buildLocalAffines(const PoseColumns& rest, const PoseColumns& pose, Affine2D* locals, size_t paddedCount);
+
+  // globals[bone] = locals[bone] * globals[parents[bone]] for every listed bone.
+  // No bone in the list may be the parent of another, so one depth level of a tree is always safe
+  void composeLevel(const UInt* bones, const UInt* parents, const Affine2D* locals, Affine2D* globals, size_t count);
+
+  // globals[i][bone] = locals[i][bone] * globals[i][parent] over count poses of one rig, each lane being a different pose
+  void composeAcross(UInt bone, UInt parent, const Affine2D* const* locals, Affine2D* const* globals, size_t count);
+}
@@ -28,4 +28,49 @@ namespace Maths
         rotation + other.rotation,
       };
     }
+
+    void Affine2D::assignTo(gef::Matrix33& transform) const
+    {
+      transform.m[0][0] = m00; transform.m[0][1] = m01; transform.m[0][2] = 0.0f;
+      transform.m[1][0] = m10; transform.m[1][1] = m11; transform.m[1][2] = 0.0f;
+      transform.m[2][0] = m20; transform.m[2][1] = m21; transform.m[2][2] = 1.0f;
+    }
+
+    void Affine2D::assignFrom(const gef::Matrix33& transform)
+    {
+      m00 = transform.m[0][0]; m01 = transform.m[0][1];
+      m10 = transform.m[1][0]; m11 = transform.m[1][1];
+      m20 = transform.m[2][0]; m21 = transform.m[2][1];
+    }
+
+    Affine2D Affine2D::operator*(const Affine2D& other) const
+    {
+      return Affine2D
+      {
+        m00 * other.m00 + m01 * other.m10, m00 * other.m01 + m01 * other.m11,
+        m10 * other.m00 + m11 * other.m10, m10 * other.m01 + m11 * other.m11,
+        m20 * other.m00 + m21 * other.m10 + other.m20, m20 * other.m01 + m21 * other.m11 + other.m21,
+      };
+    }
+
+    Region2D transformBounds(const Region2D& box, const Affine2D& transform)
+    {
+      // Move the centre, then project the half extents onto each axis
+      const float centreX = (box.left + box.right) * .5f, centreY = (box.bottom + box.top) * .5f;
+      const float halfX = (box.right - box.left) * .5f, halfY = (box.top - box.bottom) * .5f;
+
+      const float x = centreX * transform.m00 + centreY * transform.m10 + transform.m20;
+      const float y = centreX * transform.m01 + centreY * transform.m11 + transform.m21;
+      const float extentX = fabsf(transform.m00) * halfX + fabsf(transform.m10) * halfY;
+      const float extentY = fabsf(transform.m01) * halfX + fabsf(transform.m11) * halfY;
+      return Region2D{ x + extentX, y - extentY, x - extentX, y + extentY };
+    }
+
+    void mergeBounds(Region2D& bounds, const Region2D& box)
+    {
+      bounds.right = bounds.right > box.right ? bounds.right : box.right;
+      bounds.bottom = bounds.bottom < box.bottom ? bounds.bottom : box.bottom;
+      bounds.left = bounds.left < box.left ? bounds.left : box.left;
+      bounds.top = bounds.top > box.top ? bounds.top : box.top;
+    }
 }
@@ -25,4 +25,22 @@ namespace Maths
 		void assignTo(gef::Matrix33& transform) const;
 		Transform2D operator+(const Transform2D& other);
 	};
+
+	// The first two columns of a gef::Matrix33 whose last column is (0, 0, 1). Same row vector convention
+	struct Affine2D
+	{
+		float m00, m01;
+		float m10, m11;
+		float m20, m21; // Translation
+
+		void assignTo(gef::Matrix33& transform) const;
+		void assignFrom(const gef::Matrix33& transform);
+		Affine2D operator*(const Affine2D& other) const; // Applies this, then other
+	};
+
+	// Bounds as Region2D take bottom and left as the minimum corner
+	static constexpr Region2D EmptyBounds = { -3.402823466e+38f, 3.402823466e+38f, 3.402823466e+38f, -3.402823466e+38f };
+	Region2D transformBounds(const Region2D& box, const Affine2D& transform); // Bounds of the transformed box
+	void mergeBounds(Region2D& bounds, const Region2D& box);
+	inline bool overlaps(const Region2D& a, const Region2D& b) { return a.left <= b.right && b.left <= a.right && a.bottom <= b.top && b.bottom <= a.top; }
 }
\ No newline at end of file
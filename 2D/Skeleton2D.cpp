@@ -1,7 +1,10 @@
 #include <maths/math_utils.h>
 #include <graphics/sprite.h>
 #include <maths/matrix44.h>
-#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 #include "2D/Skeleton2D.h"
 #include "3D/Skeleton3D.h"
@@ -10,6 +13,7 @@ namespace Animation
 {
   Skeleton2D::Skeleton2D() : rootBoneID{NULL}
   {
+    boneCollection.setStatsName("Skeleton2D bones");
   }
 
   Skeleton2D::DetailedBone& Skeleton2D::addBone(Label name)
@@ -17,50 +21,60 @@ namespace Animation
     return boneCollection.add(name).first;
   }
 
-  bool Skeleton2D::bake()
+  bool Skeleton2D::bake(BoneOrder order)
   {
     // Ensure information is accurate
-    linkDescriptor();
+    std::vector<UInt> childStarts, children;
+    linkDescriptor(childStarts, children);
 
-    // Traverse tree by depth, ensuring bones are packed sequentially
+    // Traverse the tree without recursion, ensuring bones are packed sequentially. Deep chains cannot overflow the stack
     {
-      boneList.resize(boneCollection.getHeapSize()); // May overallocate where bone data is bad, this is not an issue
-      // The recursive step
-      std::function<void(DetailedBone&, UInt&)> nodeTraversal = [&](DetailedBone& parent, UInt& allocProgress)
+      restBones.resize(boneCollection.getHeapSize()); // May overallocate where bone data is bad, this is not an issue
+      bindPose.resize(boneCollection.getHeapSize());
+
+      // A stack visits depth-first, a queue breadth-first. Both hold heap IDs
+      std::vector<UInt> pending;
+      pending.reserve(boneCollection.getHeapSize());
+      pending.push_back(rootBoneID);
+      size_t queueHead = 0;
+
+      UInt allocProgress = 0;
+      while (queueHead < pending.size())
       {
-        // First, build self at the designated location
+        UInt heapID;
+        if (order == BoneOrder::DepthFirst) { heapID = pending.back(); pending.pop_back(); }
+        else { heapID = pending[queueHead++]; }
+
+        // Build self at the designated location
+        auto& bone = boneCollection.get(heapID);
+        bone.flattenedID = allocProgress++;
+        restBones.parents[bone.flattenedID] = bone.parentID == SNULL ? 0 : boneCollection.get(bone.parentID).flattenedID;
+        restBones.translationX[bone.flattenedID] = bone.restPose.translation.x;
+        restBones.translationY[bone.flattenedID] = bone.restPose.translation.y;
+        restBones.rotation[bone.flattenedID] = std::abs(bone.restPose.skew.x) > std::abs(bone.restPose.skew.y) ? bone.restPose.skew.x : bone.restPose.skew.y;
+
+        // Queue children. Reversed on the stack so they still pop in declaration order
+        if (order == BoneOrder::DepthFirst)
         {
-          auto& flatParent = boneList[allocProgress];
-          flatParent.restTransform = { parent.restPose.translation, gef::Vector2::kOne, std::abs(parent.restPose.skew.x) > std::abs(parent.restPose.skew.y) ? parent.restPose.skew.x : parent.restPose.skew.y };
-          flatParent.localTransform = { gef::Vector2::kZero, gef::Vector2::kOne, .0f };
+          for (UInt i = childStarts[heapID + 1]; i > childStarts[heapID]; --i) { pending.push_back(children[i - 1]); }
         }
-
-        // Now explore children
-        for(auto& childID : parent.children)
+        else
         {
-          auto& childBone = boneCollection.get(childID);
-          childBone.flattenedID = ++allocProgress;
-
-          auto& flatBone = boneList[allocProgress];
-          flatBone.parent = parent.flattenedID;
-
-          nodeTraversal(childBone, allocProgress);
+          pending.insert(pending.end(), children.begin() + childStarts[heapID], children.begin() + childStarts[heapID + 1]);
         }
-
-      };
-
-      // Start from the root and build the flattened skeletal structure
-      auto& rootBone = boneCollection.get(rootBoneID);
-      rootBone.flattenedID = 0;
-      UInt progress = 0;
-      nodeTraversal(rootBone, progress);
+      }
 
       // Set the global transform to identity
-      boneList[0].globalTransform.SetIdentity();
+      bindPose.globalTransforms[0] = { 1.f, .0f, .0f, 1.f, .0f, .0f };
     }
+    resetPose(bindPose);
+    buildTraversal(order);
 
     // Generate global transforms for reference
-    forwardKinematics(boneList);
+    forwardKinematics(bindPose);
+
+    // Bone names are final now
+    boneCollection.freeze();
 
     return isBaked();
   }
@@ -70,7 +84,7 @@ namespace Animation
     if (!isBaked()) { return false; }
 
     inst.baseSkeleton = this;
-    inst.boneList = boneList;
+    inst.bones = bindPose; // Only pose state is copied, the rest pose stays here
 
     return true;
   }
@@ -84,62 +98,264 @@ namespace Animation
     return boneID == SNULL ? SNULL : boneCollection.get(boneID).flattenedID;
   }
 
-  Maths::Transform2D& Skeleton2D::getLocalPose(std::vector<FlatBone>& bones, UInt flatID)
+  void Skeleton2D::RestArrays::resize(size_t boneCount)
+  {
+    const size_t padded = Maths::padToKinematicsWidth(boneCount);
+
+    parents.resize(boneCount, 0);
+    for (auto column : { &translationX, &translationY, &rotation })
+    {
+      column->resize(padded, .0f);
+    }
+  }
+
+  void Skeleton2D::BoneArrays::resize(size_t boneCount)
+  {
+    const size_t padded = Maths::padToKinematicsWidth(boneCount);
+
+    globalTransforms.resize(boneCount);
+    dirty.resize(boneCount, 1);
+    for (auto column : { &translationX, &translationY, &rotation, &scaleX, &scaleY })
+    {
+      column->resize(padded, .0f);
+    }
+  }
+
+  void Skeleton2D::setLocal(BoneArrays& bones, UInt flatID, const Maths::Transform2D& localTransform)
+  {
+    if (bones.translationX[flatID] == localTransform.translation.x && bones.translationY[flatID] == localTransform.translation.y &&
+      bones.rotation[flatID] == localTransform.rotation && bones.scaleX[flatID] == localTransform.scale.x && bones.scaleY[flatID] == localTransform.scale.y)
+    {
+      return; // Constant tracks land here
+    }
+
+    bones.dirty[flatID] = 1;
+    bones.translationX[flatID] = localTransform.translation.x;
+    bones.translationY[flatID] = localTransform.translation.y;
+    bones.rotation[flatID] = localTransform.rotation;
+    bones.scaleX[flatID] = localTransform.scale.x;
+    bones.scaleY[flatID] = localTransform.scale.y;
+  }
+
+  void Skeleton2D::applyLocal(BoneArrays& bones, UInt flatID, const Maths::Transform2D& localTransform)
+  {
+    // Matches Transform2D::operator+
+    bones.dirty[flatID] = 1;
+    bones.translationX[flatID] += localTransform.translation.x;
+    bones.translationY[flatID] += localTransform.translation.y;
+    bones.rotation[flatID] += localTransform.rotation;
+    bones.scaleX[flatID] *= localTransform.scale.x;
+    bones.scaleY[flatID] *= localTransform.scale.y;
+  }
+
+  void Skeleton2D::resetPose(BoneArrays& bones)
+  {
+    // Padding is reset too so the kernels never read stale lanes
+    std::fill(bones.translationX.begin(), bones.translationX.end(), .0f);
+    std::fill(bones.translationY.begin(), bones.translationY.end(), .0f);
+    std::fill(bones.rotation.begin(), bones.rotation.end(), .0f);
+    std::fill(bones.scaleX.begin(), bones.scaleX.end(), 1.f);
+    std::fill(bones.scaleY.begin(), bones.scaleY.end(), 1.f);
+    std::fill(bones.dirty.begin(), bones.dirty.end(), 1);
+  }
+
+  void Skeleton2D::setWorldTransform(BoneArrays& bones, const gef::Matrix33& worldMat)
+  {
+    Maths::Affine2D world;
+    world.assignFrom(worldMat);
+    if (std::memcmp(&world, &bones.globalTransforms[0], sizeof(world)) != 0)
+    {
+      bones.globalTransforms[0] = world;
+      bones.dirty[0] = 1;
+    }
+  }
+
+  void Skeleton2D::forwardKinematics(BoneArrays& bones) const
+  {
+    const size_t stale = countStale(bones);
+    if (stale * 2 <= bones.size())
+    {
+      if (stale) { solveSubtrees(bones); }
+      std::fill(bones.dirty.begin(), bones.dirty.end(), 0);
+      return;
+    }
+
+    // Local transforms have no dependencies, so build them all in one vectorised pass
+    thread_local std::vector<Maths::Affine2D> locals;
+    locals.resize(bones.translationX.size());
+    Maths::buildLocalAffines(getRestColumns(), getPoseColumns(bones), locals.data(), locals.size());
+
+    // Then compose a depth level at a time, every parent having been finished by the level before
+    for (size_t level = 0; level + 1 < levelStarts.size(); ++level)
+    {
+      Maths::composeLevel(levelOrder.data() + levelStarts[level], restBones.parents.data(), locals.data(), bones.globalTransforms.data(), levelStarts[level + 1] - levelStarts[level]);
+    }
+    std::fill(bones.dirty.begin(), bones.dirty.end(), 0);
+  }
+
+  void Skeleton2D::forwardKinematics(BoneArrays* const* poses, size_t count) const
   {
-    return bones[flatID].localTransform;
+    thread_local std::vector<Maths::Affine2D> locals;
+    thread_local std::vector<const Maths::Affine2D*> localPoses;
+    thread_local std::vector<Maths::Affine2D*> globalPoses;
+
+    const size_t stride = Maths::padToKinematicsWidth(getBoneCount());
+    locals.resize(stride * count);
+    localPoses.clear();
+    globalPoses.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+      // Mostly settled poses are patched on their own, the rest are solved together
+      BoneArrays& pose = *poses[i];
+      const size_t stale = countStale(pose);
+      if (stale * 2 <= pose.size())
+      {
+        if (stale) { solveSubtrees(pose); }
+      }
+      else
+      {
+        Maths::Affine2D* poseLocals = locals.data() + stride * localPoses.size();
+        Maths::buildLocalAffines(getRestColumns(), getPoseColumns(pose), poseLocals, stride);
+        localPoses.push_back(poseLocals);
+        globalPoses.push_back(pose.globalTransforms.data());
+      }
+      std::fill(pose.dirty.begin(), pose.dirty.end(), 0);
+    }
+
+    // Each bone is composed across every pose before moving on, so lanes stay full even on narrow levels such as chains
+    for (UInt bone : levelOrder)
+    {
+      Maths::composeAcross(bone, restBones.parents[bone], localPoses.data(), globalPoses.data(), localPoses.size());
+    }
   }
 
-  void Skeleton2D::resetPose(std::vector<FlatBone>& bones)
+  size_t Skeleton2D::countStale(BoneArrays& bones) const
   {
-    for (size_t i = 1; i < bones.size(); ++i)
+    if (subtreeEnds.empty())
+    {
+      // Breadth-first subtrees are scattered, so push the flags down instead. Parents still come first
+      size_t stale = bones.size() ? bones.dirty[0] : 0;
+      for (size_t i = 1; i < bones.size(); ++i)
+      {
+        bones.dirty[i] |= bones.dirty[restBones.parents[i]];
+        stale += bones.dirty[i];
+      }
+      return stale;
+    }
+
+    size_t stale = 0;
+    for (size_t i = 0; i < bones.size();)
     {
-      auto& bone = bones[i];
-      bone.localTransform.scale = gef::Vector2::kOne;
-      bone.localTransform.translation = gef::Vector2::kZero;
-      bone.localTransform.rotation = 0.f;
+      if (bones.dirty[i])
+      {
+        // Everything below is stale too, so skip over it
+        stale += subtreeEnds[i] - i;
+        i = subtreeEnds[i];
+      }
+      else { ++i; }
     }
+    return stale;
   }
 
-  void Skeleton2D::forwardKinematics(std::vector<FlatBone>& bones)
+  void Skeleton2D::solveSubtrees(BoneArrays& bones) const
   {
-    // Start after the root and traverse the tree linearly
-    for (size_t i = 1; i < bones.size(); ++i)
+    const Maths::PoseColumns rest = getRestColumns();
+    const Maths::PoseColumns pose = getPoseColumns(bones);
+
+    // The root's global is set directly, so start beneath it
+    if (subtreeEnds.empty())
     {
-      auto& thisBone = bones[i];
-      auto& thisParent = bones[thisBone.parent];
+      // Flags were already pushed down by countStale
+      for (size_t bone = 1; bone < bones.size(); ++bone)
+      {
+        if (bones.dirty[bone]) { bones.globalTransforms[bone] = Maths::buildLocalAffine(rest, pose, bone) * bones.globalTransforms[restBones.parents[bone]]; }
+      }
+      return;
+    }
 
-      gef::Matrix33 localMat;
-      Maths::Transform2D combinedTransform = thisBone.restTransform + thisBone.localTransform;
-      combinedTransform.assignTo(localMat);
+    for (size_t i = 1; i < bones.size();)
+    {
+      if (!bones.dirty[i]) { ++i; continue; }
 
-      thisBone.globalTransform = localMat * thisParent.globalTransform;
+      // Parents come first within the range, so a linear walk is enough
+      for (size_t bone = i; bone < subtreeEnds[i]; ++bone)
+      {
+        bones.globalTransforms[bone] = Maths::buildLocalAffine(rest, pose, bone) * bones.globalTransforms[restBones.parents[bone]];
+      }
+      i = subtreeEnds[i];
     }
   }
 
-  void Skeleton2D::linkDescriptor()
+  void Skeleton2D::buildTraversal(BoneOrder order)
   {
-    // Clean previous attempts and search for the root
-    for (size_t id = 0; id < boneCollection.getHeapSize(); ++id)
+    // Parents always precede their children in the flattened order, so depths resolve in one pass
+    std::vector<UInt> depths(restBones.size(), 0);
+    UInt maxDepth = 0;
+    for (size_t i = 1; i < restBones.size(); ++i)
+    {
+      depths[i] = depths[restBones.parents[i]] + 1;
+      maxDepth = std::max(maxDepth, depths[i]);
+    }
+
+    // Counting sort by depth. levelStarts[d] ends up as the end of depth d, which is the start of depth d + 1
+    levelStarts.assign(maxDepth + 1, 0);
+    for (size_t i = 1; i < restBones.size(); ++i) { ++levelStarts[depths[i]]; }
+    for (size_t d = 1; d < levelStarts.size(); ++d) { levelStarts[d] += levelStarts[d - 1]; }
+
+    std::vector<UInt> cursors(levelStarts.begin(), levelStarts.end() - 1);
+    levelOrder.resize(levelStarts.back());
+    for (size_t i = 1; i < restBones.size(); ++i)
+    {
+      levelOrder[cursors[depths[i] - 1]++] = static_cast<UInt>(i);
+    }
+
+    leaves.assign(restBones.size(), 1);
+    for (size_t i = 1; i < restBones.size(); ++i) { leaves[restBones.parents[i]] = 0; }
+
+    // Children follow their parent, so walking backwards pushes each subtree's end up to the parent
+    subtreeEnds.clear();
+    if (order != BoneOrder::DepthFirst) { return; }
+    subtreeEnds.resize(restBones.size());
+    for (size_t i = 0; i < restBones.size(); ++i) { subtreeEnds[i] = static_cast<UInt>(i + 1); }
+    for (size_t i = restBones.size(); i-- > 1;)
+    {
+      UInt& parentEnd = subtreeEnds[restBones.parents[i]];
+      parentEnd = std::max(parentEnd, subtreeEnds[i]);
+    }
+  }
+
+  void Skeleton2D::linkDescriptor(std::vector<UInt>& childStarts, std::vector<UInt>& children)
+  {
+    const size_t boneCount = boneCollection.getHeapSize();
+
+    // Resolve parents and search for the root
+    childStarts.assign(boneCount + 1, 0);
+    for (size_t id = 0; id < boneCount; ++id)
     {
       auto& bone = boneCollection.get(id);
 
-      bone.children.clear();
+      bone.flattenedID = SNULL; // Stays so if unreachable from the root
+      bone.parentID = bone.parentName.empty() ? SNULL : boneCollection.getID(bone.parentName);
       if(bone.parentName.empty()) // Assume root has no parent
       {
         rootBoneID = static_cast<UInt>(id);
       }
+      else if (bone.parentID != SNULL)
+      {
+        ++childStarts[bone.parentID + 1];
+      }
     }
 
-    // Link children to their parent
-    for (size_t childID = 0; childID < boneCollection.getHeapSize(); ++childID)
+    // Counting sort children by parent. Heap order is kept within each parent
+    for (size_t id = 0; id < boneCount; ++id) { childStarts[id + 1] += childStarts[id]; }
+    children.resize(childStarts[boneCount]);
+    std::vector<UInt> cursors(childStarts.begin(), childStarts.end() - 1);
+    for (size_t childID = 0; childID < boneCount; ++childID)
     {
-      auto& childBone = boneCollection.get(childID);
-
-      UInt parentHeapID = boneCollection.getID(childBone.parentName);
-      if(parentHeapID != SNULL)
+      UInt parentHeapID = boneCollection.get(childID).parentID;
+      if (parentHeapID != SNULL)
       {
-        boneCollection.get(parentHeapID)
-          .children.push_back(childID);
+        children[cursors[parentHeapID]++] = static_cast<UInt>(childID);
       }
     }
   }
@@ -159,6 +375,7 @@ namespace Animation
         bakedDrawOrder[slotInfo.priority] = (boneFlatID == SNULL) ? 0 : boneFlatID;
       }
     }
+    slotMap.freeze();
 
     return isBaked();
   }
@@ -177,10 +394,11 @@ namespace Animation
     return NULL;
   }
 
-  SkinnedSkeleton2D::SkinnedSkeleton2D()
+  SkinnedSkeleton2D::SkinnedSkeleton2D() : detailedAnimationData{ &detailedArena }, bakeSettings{}, resampleReport{}, compressionReport{}
   {
     atlas = nullptr;
     baked = false;
+    detailedAnimationData.setStatsName("Skeleton2D animations");
   }
 
   SkinnedSkeleton2D::~SkinnedSkeleton2D()
@@ -188,10 +406,10 @@ namespace Animation
     wipeBakedAnimations();
   }
 
-  bool SkinnedSkeleton2D::bake(Textures::TextureAtlas* atlasTextures)
+  bool SkinnedSkeleton2D::bake(Textures::TextureAtlas* atlasTextures, Skeleton2D::BoneOrder order)
   {
     baked = true;
-    baked = baked && skeleton.bake();
+    baked = baked && skeleton.bake(order);
     baked = baked && atlasTextures->isBaked();
     atlas = atlasTextures;
 
@@ -204,23 +422,39 @@ namespace Animation
     // Animations
     {
       wipeBakedAnimations();
-      animations.resize(detailedAnimationData.getHeapSize());
-      for (UInt animID = 0; animID < animations.size(); ++animID)
+      resampleReport = {};
+      compressionReport = {};
+
+      // Each animation is one block holding a track per bone, and all of them share a single allocation
+      BlockWriter block;
+      std::vector<size_t> animationOffsets(detailedAnimationData.getHeapSize());
+      std::vector<const DopeSheet2D::DetailedTrack*> boneTracks;
+      for (UInt animID = 0; animID < animationOffsets.size(); ++animID)
       {
         auto& detailedSheet = detailedAnimationData.get(animID);
 
-        auto& slotTracks = animations[animID];
-        slotTracks.resize(skeleton.getBoneCount(), nullptr);
-
+        boneTracks.assign(skeleton.getBoneCount(), nullptr);
         detailedSheet.inspectTracks([&](gef::StringId slotNameID, const DopeSheet2D::DetailedTrack& detailedTrack) {
           UInt boneHeapID = skeleton.getBoneFlatID(slots.getSlotBone(slotNameID));
           if (boneHeapID == SNULL) { return; }
 
           // Place the baked track in the same location as the bone
-          slotTracks[boneHeapID] = detailedSheet.bakeTrack(detailedTrack);
+          boneTracks[boneHeapID] = &detailedTrack;
         });
+
+        DopeSheet2D::ResampleReport resampled;
+        DopeSheet2D::CompressionReport compressed;
+        animationOffsets[animID] = detailedSheet.writeAnimation(boneTracks.data(), boneTracks.size(), block, bakeSettings, &resampled, &compressed);
+        resampleReport.merge(resampled);
+        compressionReport.merge(compressed);
+      }
+
+      // Offsets only resolve once the block has stopped moving
+      bakedAnimations = block.finish();
+      for (size_t offset : animationOffsets)
+      {
+        animations.push_back(reinterpret_cast<const DopeSheet2D::BakedAnimation*>(bakedAnimations.get() + offset));
       }
-      
     }
 
     return baked;
@@ -233,6 +467,7 @@ namespace Animation
     inst.baseSkeleton = this;
     skeleton.bindTo(inst.skeleInst);
     setAnimation(inst, 0);
+    inst.updateBounds();
     return true;
   }
 
@@ -246,18 +481,92 @@ namespace Animation
     inst.currentAnimation = animID;
     if (isBaked())
     {
-      // Copy animation data over to the player
-      inst.animationPlayer.setSheet(&detailedAnimationData.get(animID));
-      inst.animationPlayer.resizeTracks(skeleton.getBoneCount());
-      auto& bakedTracks = animations[animID];
-      for (size_t trackID = 0; trackID < bakedTracks.size(); ++trackID)
+      // Rigs without that animation, or any at all, are left at rest
+      if (animID < animations.size())
       {
-        inst.animationPlayer.setTrack(trackID, bakedTracks[trackID]);
+        // Copy animation data over to the player
+        inst.animationPlayer.setSheet(&detailedAnimationData.get(animID));
+        inst.animationPlayer.resizeTracks(skeleton.getBoneCount());
+        const DopeSheet2D::BakedAnimation* bakedAnimation = animations[animID];
+        for (size_t trackID = 0; trackID < bakedAnimation->getTrackCount(); ++trackID)
+        {
+          inst.animationPlayer.setTrack(trackID, bakedAnimation->getTrack(trackID));
+        }
+
+        inst.animationPlayer.reset();
+        inst.setPlaying(true);
+      }
+
+      // Bones the previous animation moved may have no track here
+      Skeleton2D::resetPose(inst.skeleInst.bones);
+      inst.poseSampled = false;
+    }
+  }
+
+  void SkinnedSkeleton2D::updateInstances(Instance* instances, size_t count, float dt)
+  {
+    if (!isBaked()) { return; }
+
+    // Instances are walked in tiles small enough for their poses to stay in cache while going bone by bone
+    thread_local std::vector<Instance*> tile;
+    thread_local std::vector<float> tileExtents; // LOD extent of each tile instance
+    thread_local std::vector<Instance*> posed; // Bounds to refit after FK
+    thread_local std::vector<Skeleton2D::BoneArrays*> poses;
+    for (size_t tileStart = 0; tileStart < count; tileStart += instanceTileSize)
+    {
+      tile.clear();
+      tileExtents.clear();
+      posed.clear();
+      poses.clear();
+      for (size_t i = tileStart; i < std::min(count, tileStart + instanceTileSize); ++i)
+      {
+        auto& inst = instances[i];
+        if (inst.baseSkeleton != this) { continue; }
+
+        // Rigs without an animation still need FK for moves made through setWorldTransform
+        poses.push_back(&inst.skeleInst.bones);
+        const bool animated = inst.currentAnimation < animations.size();
+        if (animated) { inst.animationPlayer.update(dt); }
+        if (animated && inst.shouldSample())
+        {
+          tile.push_back(&inst);
+          tileExtents.push_back(inst.getLodExtent());
+          inst.poseSampled = true;
+          posed.push_back(&inst);
+        }
+        else if (inst.skeleInst.bones.dirty[0])
+        {
+          posed.push_back(&inst);
+        }
+      }
+
+      // Sample bone-major so the draw order and each bone's tracks are read once per tile
+      for (size_t i = 0; i < skeleton.getBoneCount(); ++i)
+      {
+        UInt boneHeapID = slots.getBoneID(i);
+        if (!boneHeapID) { continue; } // The root is not animated
+
+        for (size_t t = 0; t < tile.size(); ++t)
+        {
+          Instance* inst = tile[t];
+          if (!animations[inst->currentAnimation]->getTrack(boneHeapID) || !inst->isBoneSampled(boneHeapID, tileExtents[t])) { continue; } // Untracked bones stay at rest
+          Skeleton2D::setLocal(inst->skeleInst.bones, boneHeapID, inst->animationPlayer.getCurrentTransform(boneHeapID));
+        }
       }
 
-      inst.animationPlayer.reset();
-      inst.setPlaying(true);
+      skeleton.forwardKinematics(poses.data(), poses.size());
+      for (Instance* inst : posed) { inst->updateBounds(); }
+    }
+  }
+
+  size_t SkinnedSkeleton2D::cullInstances(Instance* instances, size_t count, const Maths::Region2D& view, bool pauseAnimation)
+  {
+    size_t visible = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      visible += instances[i].cull(view, pauseAnimation) ? 1 : 0;
     }
+    return visible;
   }
 
   DopeSheet2D::DetailedTrack& SkinnedSkeleton2D::getAnimationTrack(UInt animID, Label slotName)
@@ -267,37 +576,62 @@ namespace Animation
 
   void SkinnedSkeleton2D::wipeBakedAnimations()
   {
-    for (auto& bakedAnimation : animations)
-    {
-      for (auto& bakedTrack : bakedAnimation)
-      {
-        delete bakedTrack;
-      }
-    }
+    // Baked animations hold no pointers or destructors, so the one allocation is all there is to free
     animations.clear();
+    bakedAnimations.reset();
   }
 
   bool Skeleton2DSkin::bake(const Skeleton2D& skele, const Skeleton2DSlots& slotMap, const Textures::TextureAtlas& atlas)
   {
-    if (!skele.isBaked() || !atlas.isBaked()) { return false; }
+    baked = false;
+    if (!skele.isBaked() || !atlas.isBaked() || !slotMap.isBaked()) { return false; }
 
-    // Build the subtexture info as it relates to the optimised bone order
-    bakedSubtextureLinks.resize(skele.getBoneCount());
+    // Gather each linked bone's part by the optimised bone order
+    std::vector<DrawPart> boneParts(skele.getBoneCount());
+    std::vector<bool> linked(skele.getBoneCount(), false);
     for (auto& slot : slots)
     {
       gef::StringId boneNameID = slotMap.getSlotBone(slot.first);
       UInt boneFlatID = skele.getBoneFlatID(boneNameID);
       if (boneFlatID == SNULL) { continue; }
 
-      // Build the offset transform
-      auto& bakedLink = bakedSubtextureLinks[boneFlatID];
-      slot.second.offset.assignTo(bakedLink.offsetTransform);
-      
       // Assign the atlas ID
       UInt atlasRegionID = atlas.getRegionID(atlas.getDivision(slot.second.subName));
-      bakedLink.subtextureID = atlasRegionID == SNULL ? 0 : atlasRegionID;
+      auto& part = boneParts[boneFlatID];
+      part.boneFlatID = boneFlatID;
+      part.subtextureID = atlasRegionID == SNULL ? 0 : atlasRegionID;
+
+      // Fold the subtexture and skin offset transforms together, leaving one multiply per bone at render
+      auto divData = atlas.getData(part.subtextureID);
+      gef::Matrix33 offsetTransform;
+      slot.second.offset.assignTo(offsetTransform);
+      part.spriteTransform.assignFrom(divData->transform * offsetTransform);
+      part.uv = divData->uv;
+      part.bounds = Maths::transformBounds({ .5f, -.5f, -.5f, .5f }, part.spriteTransform);
+      part.extent = std::max(part.bounds.right - part.bounds.left, part.bounds.top - part.bounds.bottom);
+      linked[boneFlatID] = true;
+    }
+
+    // Children follow their parent, so walking backwards pushes each subtree's largest part up to the parent
+    subtreeExtents.assign(skele.getBoneCount(), .0f);
+    for (UInt i = static_cast<UInt>(skele.getBoneCount()); i-- > 0;)
+    {
+      if (linked[i]) { subtreeExtents[i] = std::max(subtreeExtents[i], boneParts[i].extent); }
+      if (i) { subtreeExtents[skele.getParent(i)] = std::max(subtreeExtents[skele.getParent(i)], subtreeExtents[i]); }
     }
 
+    // Lay the parts out in draw order
+    bakedDrawParts.clear();
+    for (UInt i = 0; i < skele.getBoneCount(); ++i)
+    {
+      UInt boneFlatID = slotMap.getBoneID(i);
+      if (boneFlatID && linked[boneFlatID]) // We don't need to draw the root
+      {
+        bakedDrawParts.push_back(boneParts[boneFlatID]);
+      }
+    }
+
+    baked = true;
     return isBaked();
   }
 
@@ -317,7 +651,7 @@ namespace Animation
     transform = rotMat * transMat;
   }
 
-  SkinnedSkeleton2D::Instance::Instance() : baseSkeleton{ nullptr }, currentAnimation{ NULL }, currentSkin{ NULL }
+  SkinnedSkeleton2D::Instance::Instance() : baseSkeleton{ nullptr }, currentAnimation{ NULL }, currentSkin{ NULL }, poseSampled{ false }, bounds(Maths::EmptyBounds), culled{ false }, animationCulled{ false }, lodProfile{ SNULL }, lodFrame{ 0 }
   {
 
   }
@@ -326,26 +660,114 @@ namespace Animation
   {
     if (!baseSkeleton) { return; }
 
-    Skeleton2D::resetPose(skeleInst.boneList);
-    animationPlayer.update(dt);
+    // Rigs without an animation still need FK for moves made through setWorldTransform
+    const bool animated = currentAnimation < baseSkeleton->animations.size();
+    if (animated) { animationPlayer.update(dt); }
 
-    for (size_t i = 0; i < skeleInst.baseSkeleton->getBoneCount(); ++i)
+    // Poses persist between frames, so bones whose track holds still are left clean
+    bool posed = skeleInst.bones.dirty[0] != 0; // Moved in the world
+    if (animated && shouldSample())
     {
-      // Convert to the optimised bone index
-      if (UInt boneHeapID = baseSkeleton->getSlots().getBoneID(i)) // We don't need to draw the root
+      const DopeSheet2D::BakedAnimation* bakedAnimation = baseSkeleton->animations[currentAnimation];
+      const float minExtent = getLodExtent();
+      for (size_t i = 0; i < skeleInst.baseSkeleton->getBoneCount(); ++i)
       {
-        // Apply the current animation
-        auto& localPose = Skeleton2D::getLocalPose(skeleInst.boneList, boneHeapID);
-        localPose = localPose + animationPlayer.getCurrentTransform(boneHeapID);
+        // Convert to the optimised bone index
+        UInt boneHeapID = baseSkeleton->getSlots().getBoneID(i);
+        if (boneHeapID && bakedAnimation->getTrack(boneHeapID) && isBoneSampled(boneHeapID, minExtent)) // We don't need to draw the root, untracked bones stay at rest
+        {
+          // Apply the current animation
+          Skeleton2D::setLocal(skeleInst.bones, boneHeapID, animationPlayer.getCurrentTransform(boneHeapID));
+        }
       }
+      poseSampled = true;
+      posed = true;
     }
 
-    Skeleton2D::forwardKinematics(skeleInst.boneList);
+    skeleInst.baseSkeleton->forwardKinematics(skeleInst.bones);
+    if (posed) { updateBounds(); }
+  }
+
+  void SkinnedSkeleton2D::Instance::updateBounds()
+  {
+    bounds = Maths::EmptyBounds;
+    if (!hasSkin() || !getQuadCount()) { return; }
+
+    for (auto& part : baseSkeleton->skins[currentSkin].getDrawParts())
+    {
+      Maths::mergeBounds(bounds, Maths::transformBounds(part.bounds, Skeleton2D::getBoneTransform(skeleInst.bones, part.boneFlatID)));
+    }
+  }
+
+  bool SkinnedSkeleton2D::Instance::shouldSample()
+  {
+    if (!poseSampled) { return true; }
+    if (!animationPlayer.isPlaying() || animationCulled) { return false; }
+    if (lodProfile == SNULL) { return true; }
+
+    // Reduced rate sampling holds the last pose in between
+    const UInt interval = std::max(baseSkeleton->lodProfiles[lodProfile].sampleInterval, 1u);
+    lodFrame = (lodFrame + 1) % interval;
+    return lodFrame == 0;
+  }
+
+  float SkinnedSkeleton2D::Instance::getLodExtent() const
+  {
+    if (lodProfile == SNULL) { return .0f; }
+
+    // Sprite space is in pixels, so the larger world axis scale projects bone space extents onto the screen
+    const auto& world = Skeleton2D::getBoneTransform(skeleInst.bones, 0);
+    const float scale = std::sqrt(std::max(world.m00 * world.m00 + world.m01 * world.m01, world.m10 * world.m10 + world.m11 * world.m11));
+    const float minPixelSize = baseSkeleton->lodProfiles[lodProfile].minPixelSize;
+    return scale > .0f ? minPixelSize / scale : std::numeric_limits<float>::max(); // A collapsed rig draws nothing
+  }
+
+  bool SkinnedSkeleton2D::Instance::isBoneSampled(UInt flatID, float minExtent) const
+  {
+    if (lodProfile == SNULL || !hasSkin()) { return true; } // Without a skin there are no extents to judge by
+    if (baseSkeleton->lodProfiles[lodProfile].mergeLeaves && baseSkeleton->skeleton.isLeaf(flatID)) { return false; }
+    return baseSkeleton->skins[currentSkin].getSubtreeExtent(flatID) >= minExtent;
+  }
+
+  void SkinnedSkeleton2D::Instance::setLod(UInt profileID)
+  {
+    lodProfile = profileID;
+    lodFrame = 0;
+    poseSampled = false; // Bones the previous profile skipped may be stale
+    if (profileID == SNULL || !baseSkeleton || !baseSkeleton->lodProfiles[profileID].mergeLeaves) { return; }
+
+    // Merged leaves are never sampled again, so settle them at rest rather than leave whatever pose they last had
+    Maths::Transform2D rest;
+    rest.translation = gef::Vector2::kZero;
+    rest.scale = gef::Vector2::kOne;
+    rest.rotation = .0f;
+    const Skeleton2D& skeleton = baseSkeleton->skeleton;
+    for (UInt flatID = 1; flatID < skeleton.getBoneCount(); ++flatID)
+    {
+      if (skeleton.isLeaf(flatID)) { Skeleton2D::setLocal(skeleInst.bones, flatID, rest); }
+    }
+  }
+
+  bool SkinnedSkeleton2D::Instance::cull(const Maths::Region2D& view, bool pauseAnimation)
+  {
+    culled = !Maths::overlaps(bounds, view);
+    animationCulled = culled && pauseAnimation;
+    return !culled;
   }
 
   void SkinnedSkeleton2D::Instance::render(gef::SpriteRenderer* renderer, const Textures::TextureCollection& textures)
   {
-    if (!baseSkeleton || !baseSkeleton->isBaked() || !baseSkeleton->getAtlas()) { return; }
+    renderTo(renderer, textures);
+  }
+
+  void SkinnedSkeleton2D::Instance::render(Textures::SpriteRasterizer* rasterizer, const Textures::TextureCollection& textures)
+  {
+    renderTo(rasterizer, textures);
+  }
+
+  template<typename Renderer> void SkinnedSkeleton2D::Instance::renderTo(Renderer* renderer, const Textures::TextureCollection& textures)
+  {
+    if (culled || !hasSkin() || !baseSkeleton->isBaked() || !baseSkeleton->getAtlas()) { return; }
 
     // Hold a sprite with the texture atlas
     gef::Sprite sprite;
@@ -354,33 +776,84 @@ namespace Animation
       sprite.set_texture(textures.getTextureData(baseSkeleton->getAtlas()->getTextureID()));
     }
 
-    auto& skin = baseSkeleton->getSkin(currentSkin);
-
-    // Traverse the draw list
-    for (size_t i = 0; i < skeleInst.baseSkeleton->getBoneCount(); ++i)
+    // Traverse the draw list, the skin already holds the sprite offset and subtexture transforms combined
+    gef::Matrix33 finalTransform;
+    const float minExtent = getLodExtent();
+    for (auto& part : baseSkeleton->getSkin(currentSkin).getDrawParts())
     {
-      // Convert to the optimised bone index
-      if (UInt boneHeapID = baseSkeleton->getSlots().getBoneID(i)) // We don't need to draw the root
-      {
-        auto divData = baseSkeleton->getAtlas()->getData(skin.getSubtextureID(boneHeapID));
+      if (part.extent < minExtent) { continue; } // Below the LOD pixel threshold
+
+      // Assign texture region
+      sprite.set_uv_width(part.uv.right - part.uv.left);
+      sprite.set_uv_height(part.uv.top - part.uv.bottom);
+      sprite.set_uv_position({ part.uv.left, part.uv.bottom });
+
+      // Build the sprite transform
+      (part.spriteTransform * Skeleton2D::getBoneTransform(skeleInst.bones, part.boneFlatID)).assignTo(finalTransform);
+
+      // Render!
+      renderer->DrawSprite(sprite, finalTransform);
+    }
+  }
 
-        // Assign texture region
-        sprite.set_uv_width(divData->uv.right - divData->uv.left);
-        sprite.set_uv_height(divData->uv.top - divData->uv.bottom);
-        sprite.set_uv_position({ divData->uv.left, divData->uv.bottom });
+  size_t SkinnedSkeleton2D::Instance::getQuadCount() const
+  {
+    if (!hasSkin() || !baseSkeleton->isBaked() || !baseSkeleton->atlas) { return 0; }
 
-        // Build the sprite transform
-        gef::Matrix33 finalTransform = gef::Matrix33::kIdentity;
-        finalTransform = Skeleton2D::getBoneTransform(skeleInst.boneList, boneHeapID) * finalTransform; // Apply world
-        finalTransform = skin.getTransform(boneHeapID) * finalTransform; // Apply sprite offset
-        finalTransform = divData->transform * finalTransform; // Apply subtexture offset
+    auto& parts = baseSkeleton->skins[currentSkin].getDrawParts();
+    const float minExtent = getLodExtent();
+    if (minExtent <= .0f) { return parts.size(); }
+    return std::count_if(parts.begin(), parts.end(), [minExtent](const Skeleton2DSkin::DrawPart& part) { return part.extent >= minExtent; });
+  }
 
-        // TODO: sprite offset and subtexture transforms can be precomputed on skin swap!
+  void SkinnedSkeleton2D::Instance::writeQuads(Textures::SpriteVertex* out) const
+  {
+    if (!getQuadCount()) { return; }
 
-        // Render!
-        renderer->DrawSprite(sprite, finalTransform);
+    const float minExtent = getLodExtent();
+    for (auto& part : baseSkeleton->skins[currentSkin].getDrawParts())
+    {
+      if (part.extent < minExtent) { continue; }
+      Textures::writeQuad(part.spriteTransform * Skeleton2D::getBoneTransform(skeleInst.bones, part.boneFlatID), part.uv, out);
+      out += 4;
+    }
+  }
+
+  void SkinnedSkeleton2D::batchInstances(const Instance* const* instances, size_t count, std::vector<Textures::SpriteVertex>& vertices, std::vector<Textures::SpriteBatch>& batches)
+  {
+    vertices.clear();
+    batches.clear();
+
+    // Order drawable instances by texture. Stable, so rigs on one texture keep their relative order
+    std::vector<std::pair<UInt, const Instance*>> order;
+    order.reserve(count);
+    size_t quadCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      size_t quads = instances[i]->culled ? 0 : instances[i]->getQuadCount();
+      if (quads)
+      {
+        order.push_back({ instances[i]->baseSkeleton->atlas->getTextureID(), instances[i] });
+        quadCount += quads;
       }
     }
+    std::stable_sort(order.begin(), order.end(), [](const std::pair<UInt, const Instance*>& a, const std::pair<UInt, const Instance*>& b) { return a.first < b.first; });
+
+    // Write straight into the stream, opening a batch whenever the texture changes
+    vertices.resize(quadCount * 4);
+    UInt quad = 0;
+    for (auto& entry : order)
+    {
+      if (batches.empty() || batches.back().textureID != entry.first)
+      {
+        batches.push_back({ entry.first, quad, 0 });
+      }
+
+      entry.second->writeQuads(vertices.data() + quad * 4);
+      UInt quads = static_cast<UInt>(entry.second->getQuadCount());
+      batches.back().quadCount += quads;
+      quad += quads;
+    }
   }
 
   void SkinnedSkeleton2D::Instance::setAnimation(UInt animID)
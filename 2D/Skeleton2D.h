@@ -5,10 +5,12 @@
 #include <graphics/sprite_renderer.h>
 #include <vector>
 #include <map>
-#include <list>
+#include <memory>
 #include "../Defs.h"
 #include "TextureWorks.h"
+#include "SpriteRasterizer.h"
 #include "DopeSheet.h"
+#include "Kinematics2D.h"
 
 namespace Animation
 {
@@ -36,22 +38,44 @@ namespace Animation
       // Managed
       private:
       UInt flattenedID;
-      std::list<UInt> children;
+      UInt parentID; // Heap ID of the parent, SNULL for the root
     };
 
-    // Bone traversal is optimised via a depth-first flattening of the skeleton tree
-    struct FlatBone
+    // How bake flattens the tree. Parents always precede their children either way
+    enum class BoneOrder : Byte
     {
-      UInt parent;
-      Maths::Transform2D restTransform;
-      Maths::Transform2D localTransform;
-      gef::Matrix33 globalTransform;
+      DepthFirst, // Subtrees are contiguous, which suits incremental FK
+      BreadthFirst // Depth levels are contiguous, which suits full SIMD FK batches
+    };
+
+    // Bone traversal is optimised via a flattening of the skeleton tree.
+    // Attributes are stored column-wise by flat ID so FK streams each one and batches siblings
+
+    // Topology and rest pose. Identical for every instance, so only the skeleton holds it
+    struct RestArrays
+    {
+      void resize(size_t boneCount); // Columns are padded to Maths::KinematicsWidth
+      inline size_t size() const { return parents.size(); }
+
+      std::vector<UInt> parents;
+      std::vector<float> translationX, translationY, rotation;
+    };
+
+    // Per instance pose state
+    struct BoneArrays
+    {
+      void resize(size_t boneCount); // Columns are padded to Maths::KinematicsWidth
+      inline size_t size() const { return globalTransforms.size(); }
+
+      std::vector<float> translationX, translationY, rotation, scaleX, scaleY; // Local pose, applied on top of rest
+      std::vector<Maths::Affine2D> globalTransforms;
+      std::vector<Byte> dirty; // Local pose changed since the last FK, so the bone's subtree is stale
     };
 
     // Simple container of a flattened bone list instance relative to a skeleton asset
     struct Instance
     {
-      std::vector<FlatBone> boneList;
+      BoneArrays bones;
       Skeleton2D* baseSkeleton;
     };
 
@@ -59,37 +83,57 @@ namespace Animation
 
     // Slow
     DetailedBone& addBone(Label name);
-    bool bake(); // Build an optimised representation of the skeleton
+    inline void reserveBones(size_t count) { boneCollection.reserve(count); }
+    bool bake(BoneOrder order = BoneOrder::DepthFirst); // Build an optimised representation of the skeleton
     bool bindTo(Skeleton2D::Instance& inst); // Transfers the bone list to an instance for use
     UInt getBoneFlatID(gef::StringId nameID) const;
     //
-    inline size_t getBoneCount() const { return boneList.size(); }
-    inline bool isBaked() const { return !boneList.empty(); }
+    inline size_t getBoneCount() const { return restBones.size(); }
+    inline bool isBaked() const { return restBones.size() != 0; }
+    inline UInt getParent(UInt flatID) const { return restBones.parents[flatID]; } // Parents always precede their children
+    inline bool isLeaf(UInt flatID) const { return leaves[flatID] != 0; }
     
-    static inline void setLocal(std::vector<FlatBone>& bones, UInt flatID, const Maths::Transform2D& localTransform) { bones[flatID].localTransform = localTransform; }
-    // The root bone stores the transform for the entire rig!
-    static void setWorldTransform(std::vector<FlatBone>& bones, const gef::Matrix33& worldMat) { bones[0].globalTransform = worldMat; }
-    inline static const gef::Matrix33& getBoneTransform(const std::vector<FlatBone>& bones, UInt flatID) { return bones[flatID].globalTransform; }
-    static Maths::Transform2D& getLocalPose(std::vector<FlatBone>& bones, UInt flatID); // Fetch the local pose of this bone so transforms can be applied
-    static void resetPose(std::vector<FlatBone>& bones); // Reset local transforms so new ones can be applied
-    static void forwardKinematics(std::vector<FlatBone>& bones); // Compute world transforms down a skeletal structure
+    // Pose edits only dirty the bone when the value actually changes, keeping FK incremental
+    static void setLocal(BoneArrays& bones, UInt flatID, const Maths::Transform2D& localTransform);
+    static void applyLocal(BoneArrays& bones, UInt flatID, const Maths::Transform2D& localTransform); // Compose on top of the current local pose
+    // The root bone stores the transform for the entire rig! Only the affine part is kept
+    static void setWorldTransform(BoneArrays& bones, const gef::Matrix33& worldMat);
+    inline static const Maths::Affine2D& getBoneTransform(const BoneArrays& bones, UInt flatID) { return bones.globalTransforms[flatID]; }
+    static void resetPose(BoneArrays& bones); // Reset local transforms so new ones can be applied. Dirties everything
+    // Compute world transforms down the skeletal structure. Only subtrees under dirty bones are recomputed,
+    // falling back to a full level-batched solve when most of the rig is stale
+    void forwardKinematics(BoneArrays& bones) const;
+    void forwardKinematics(BoneArrays* const* poses, size_t count) const; // Many poses of this skeleton at once, vectorised across poses
 
     private:
-    void linkDescriptor(); // Propagate skeletal structure
+    void linkDescriptor(std::vector<UInt>& childStarts, std::vector<UInt>& children); // Propagate skeletal structure into a CSR child array
+    void buildTraversal(BoneOrder order); // Group flat bones by depth for FK batching and record subtree ranges
+    size_t countStale(BoneArrays& bones) const; // Bones under a dirty bone
+    void solveSubtrees(BoneArrays& bones) const; // Recomputes the subtrees of dirty bones only, after countStale
 
-    NamedHeap<DetailedBone> boneCollection;
+    // Rest poses are shared by every instance, so FK always reads them from the skeleton
+    inline Maths::PoseColumns getRestColumns() const { return { restBones.translationX.data(), restBones.translationY.data(), restBones.rotation.data(), nullptr, nullptr }; }
+    static inline Maths::PoseColumns getPoseColumns(const BoneArrays& bones) { return { bones.translationX.data(), bones.translationY.data(), bones.rotation.data(), bones.scaleX.data(), bones.scaleY.data() }; }
+
+    NamedHeap<DetailedBone, NamedHeapInfo, FlatIndex> boneCollection;
     UInt rootBoneID; // The ID of the presumed root bone
-    std::vector<FlatBone> boneList; // Default 'bind' transforms to provide instances in a baked, flattened structure
+    RestArrays restBones; // Baked, flattened structure shared by instances
+    BoneArrays bindPose; // Default 'bind' transforms to provide instances
+    std::vector<UInt> levelOrder; // Non-root flat IDs ordered by depth
+    std::vector<UInt> levelStarts; // Start of each depth level in levelOrder, plus a final end
+    std::vector<UInt> subtreeEnds; // A depth-first bone's subtree is [flat ID, end). Empty when breadth-first
+    std::vector<Byte> leaves; // Set for bones without children
   };
 
   class Skeleton2DSlots
   {
     public:
-    Skeleton2DSlots() = default;
+    Skeleton2DSlots() { slotMap.setStatsName("Skeleton2D slots"); }
 
     bool bake(const Skeleton2D& skele);
 
     void addSlot(Label boneName, Label skinHook);
+    inline void reserveSlots(size_t count) { slotMap.reserve(count); }
     gef::StringId getSlotBone(gef::StringId slotNameID) const;
 
     inline bool isBaked() const { return !bakedDrawOrder.empty(); }
@@ -101,7 +145,7 @@ namespace Animation
       gef::StringId boneNameID;
       UInt priority; // Draw order
     };
-    NamedHeap<DetailedSlotInfo> slotMap; // Slot name to info
+    NamedHeap<DetailedSlotInfo, NamedHeapInfo, FlatIndex> slotMap; // Slot name to info
     std::vector<UInt> bakedDrawOrder; // Draw order to bone list (lookup)
   };
 
@@ -109,15 +153,26 @@ namespace Animation
   class Skeleton2DSkin
   {
     public:
+    // Everything needed to draw one bone's sprite, so a render pass reads these linearly
+    struct DrawPart
+    {
+      Maths::Affine2D spriteTransform; // Subtexture transform then skin offset, applied before the bone's global
+      Maths::Region2D uv;
+      Maths::Region2D bounds; // Sprite quad extent in bone space
+      float extent; // Larger side of bounds, compared against LOD pixel thresholds
+      UInt boneFlatID;
+      UInt subtextureID;
+    };
+
     Skeleton2DSkin() = default;
 
     bool bake(const Skeleton2D& skele, const Skeleton2DSlots& slotMap, const Textures::TextureAtlas& atlas);
 
     void addLink(Label slotName, Label subTextureName, const Skeleton2D::BonePoseOffset& offset);
 
-    inline bool isBaked() const { return !bakedSubtextureLinks.empty(); }
-    inline UInt getSubtextureID(UInt boneFlatID) const { return bakedSubtextureLinks[boneFlatID].subtextureID; }
-    inline const gef::Matrix33& getTransform(UInt boneFlatID) const { return bakedSubtextureLinks[boneFlatID].offsetTransform; }
+    inline bool isBaked() const { return baked; }
+    inline const std::vector<DrawPart>& getDrawParts() const { return bakedDrawParts; } // Draw order, root and unlinked bones excluded
+    inline float getSubtreeExtent(UInt boneFlatID) const { return subtreeExtents[boneFlatID]; } // Largest part extent in the bone's subtree
 
     private:
     struct DetailedSkinPart
@@ -125,20 +180,25 @@ namespace Animation
       gef::StringId subName; // The name of the designated subtexture part
       Skeleton2D::BonePoseOffset offset;
     };
-    struct SkinPart
-    {
-      gef::Matrix33 offsetTransform;
-      UInt subtextureID;
-    };
 
     std::unordered_map<gef::StringId, DetailedSkinPart> slots; // Slot to transform mapped to skin data
-    std::vector<SkinPart> bakedSubtextureLinks; // Bone list to its subtexture and transform
+    std::vector<DrawPart> bakedDrawParts;
+    std::vector<float> subtreeExtents; // By flat bone ID
+    bool baked = false;
   };
 
   // Full ensemble
   class SkinnedSkeleton2D
   {
     public:
+    // Reduced detail for far or small instances
+    struct LodProfile
+    {
+      float minPixelSize; // Sprites projecting smaller than this are not drawn, nor are bones sampled whose subtree draws nothing
+      UInt sampleInterval; // Sample every Nth update, holding the pose in between. 1 samples every update
+      bool mergeLeaves; // Leaf bones stop animating and ride rigidly on their parent in their rest pose
+    };
+
     class Instance
     {
       friend SkinnedSkeleton2D;
@@ -148,47 +208,95 @@ namespace Animation
 
       void update(float dt);
       void render(gef::SpriteRenderer* renderer, const Textures::TextureCollection& textures);
+      void render(Textures::SpriteRasterizer* rasterizer, const Textures::TextureCollection& textures); // Headless
+      size_t getQuadCount() const; // Quads writeQuads produces, zero when unbound
+      void writeQuads(Textures::SpriteVertex* out) const; // Same sprites as render, four vertices each in draw order
       void setAnimation(UInt animID);
+      // Tests the bounds against a view, returning visibility. Culled instances are not rendered or batched.
+      // Pausing animation also stops sampling while culled, though the player clock runs and world moves are still solved
+      bool cull(const Maths::Region2D& view, bool pauseAnimation = false);
+      void setLod(UInt profileID); // A profile of the rig, or SNULL for full detail
 
-      inline void setWorldTransform(const gef::Matrix33& worldMat) { Skeleton2D::setWorldTransform(skeleInst.boneList, worldMat); }
+      inline void setWorldTransform(const gef::Matrix33& worldMat) { Skeleton2D::setWorldTransform(skeleInst.bones, worldMat); }
+      inline const Maths::Affine2D& getBoneTransform(UInt flatID) const { return Skeleton2D::getBoneTransform(skeleInst.bones, flatID); }
       inline void setPlaying(bool animationPlay) { animationPlayer.setPlaying(animationPlay); }
+      inline void seek(float seconds) { animationPlayer.seek(seconds); poseSampled = false; } // Reposed on the next update, even while paused
       inline SkinnedSkeleton2D* getSkinnedSkeleton() { return baseSkeleton; }
-      inline void setSkin(UInt id) { currentSkin = id; }
+      inline void setSkin(UInt id) { currentSkin = id; updateBounds(); }
       inline bool getPlaying() const { return animationPlayer.isPlaying(); }
       inline UInt getCurrentAnim() const { return currentAnimation; }
+      inline const Maths::Region2D& getBounds() const { return bounds; } // Conservative world extent of every sprite, refit after FK
+      inline bool isCulled() const { return culled; }
+      inline UInt getLod() const { return lodProfile; }
 
       private:
+      template<typename Renderer> void renderTo(Renderer* renderer, const Textures::TextureCollection& textures);
+      void updateBounds();
+      inline bool hasSkin() const { return baseSkeleton && currentSkin < baseSkeleton->skins.size(); } // Rigs may bake with no skin at all
+      bool shouldSample(); // Whether this update samples the animation. Advances the LOD frame count
+      float getLodExtent() const; // Parts smaller than this, in bone space, are dropped by the LOD. Zero at full detail
+      bool isBoneSampled(UInt flatID, float minExtent) const;
+
       SkinnedSkeleton2D* baseSkeleton;
       Skeleton2D::Instance skeleInst;
       UInt currentSkin;
 
       DopePlayer2D animationPlayer;
       UInt currentAnimation;
+      bool poseSampled; // A paused player keeps producing this pose, so sampling can be skipped
+
+      Maths::Region2D bounds;
+      bool culled;
+      bool animationCulled; // Culled with sampling paused
+
+      UInt lodProfile;
+      UInt lodFrame; // Updates since the last LOD sample
     };
 
     SkinnedSkeleton2D();
     ~SkinnedSkeleton2D();
 
-    bool bake(Textures::TextureAtlas* atlas);
+    bool bake(Textures::TextureAtlas* atlas, Skeleton2D::BoneOrder order = Skeleton2D::BoneOrder::DepthFirst);
     bool bindTo(SkinnedSkeleton2D::Instance& inst); // Transfers to an instance for use
     void setAnimation(SkinnedSkeleton2D::Instance& inst, UInt anim);
+    // Same as Instance::update on each, but bone by bone across instances so shared rig data is read once.
+    // Every instance must be bound to this rig
+    void updateInstances(Instance* instances, size_t count, float dt);
+    // Writes the quads of many instances, of any rigs, into one vertex stream and groups them by atlas texture.
+    // Rigs sharing a texture are merged into a single batch, keeping submission order between them
+    static void batchInstances(const Instance* const* instances, size_t count, std::vector<Textures::SpriteVertex>& vertices, std::vector<Textures::SpriteBatch>& batches);
+    static size_t cullInstances(Instance* instances, size_t count, const Maths::Region2D& view, bool pauseAnimation = false); // Instance::cull on each, returns the number visible
 
     UInt addAnimation(Label name);
+    inline void reserveAnimations(size_t count) { detailedAnimationData.reserve(count); }
     inline DopeSheet2D& getAnimationData(UInt animID) { return detailedAnimationData.get(animID); }
     DopeSheet2D::DetailedTrack& getAnimationTrack(UInt animID, Label slotName);
 
     inline UInt addSkin() { skins.emplace_back(); return static_cast<UInt>(skins.size() - 1); }
+    inline void reserveSkins(size_t count) { skins.reserve(count); }
     inline Skeleton2DSkin& getSkin(UInt id) { return skins[id]; }
     inline Skeleton2D& getSkeleton() { return skeleton; }
     inline Skeleton2DSlots& getSlots() { return slots; }
     inline Textures::TextureAtlas* getAtlas() { return atlas; }
     inline const NamedHeap<DopeSheet2D>& getAnimations() const { return detailedAnimationData; }
     inline size_t getAnimationCount() const { return detailedAnimationData.getHeapSize(); }
+    // Resampling and compression of every baked track. Applies from the next bake
+    inline void setBakeSettings(const DopeSheet2D::BakeSettings& settings) { bakeSettings = settings; }
+    // Worst errors and total sizes over the last bake
+    inline const DopeSheet2D::ResampleReport& getResampleReport() const { return resampleReport; }
+    inline const DopeSheet2D::CompressionReport& getCompressionReport() const { return compressionReport; }
     inline bool isBaked() const { return baked; }
 
+    inline UInt addLodProfile(const LodProfile& profile) { lodProfiles.push_back(profile); return static_cast<UInt>(lodProfiles.size() - 1); }
+    inline LodProfile& getLodProfile(UInt id) { return lodProfiles[id]; }
+
     private:
+    static constexpr size_t instanceTileSize = 16; // Instances per batch in updateInstances
+
     void wipeBakedAnimations();
 
+    AssetArena detailedArena; // Imported keyframe data
+
     Skeleton2DSlots slots;
     std::vector<Skeleton2DSkin> skins;
 
@@ -196,7 +304,12 @@ namespace Animation
     Skeleton2D skeleton;
 
     NamedHeap<DopeSheet2D> detailedAnimationData;
-    std::vector<std::vector<DopeSheet2D::BakedTrack*>> animations;
+    std::unique_ptr<Byte[]> bakedAnimations; // Every baked animation back to back in one allocation, dropped wholesale on rebake
+    std::vector<const DopeSheet2D::BakedAnimation*> animations; // Into bakedAnimations
+    std::vector<LodProfile> lodProfiles;
+    DopeSheet2D::BakeSettings bakeSettings;
+    DopeSheet2D::ResampleReport resampleReport;
+    DopeSheet2D::CompressionReport compressionReport;
 
     bool baked;
   };
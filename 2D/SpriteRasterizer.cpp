@@ -0,0 +1,105 @@
+#include "2D/SpriteRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Textures
+{
+  namespace
+  {
+    // 16 bit fixed point of a UV component
+    inline UInt packUnit(float value)
+    {
+      return static_cast<UInt>(std::min(std::max(value, .0f), 1.f) * 65535.f + .5f);
+    }
+  }
+
+  SpriteRasterizer::SpriteRasterizer(UInt width, UInt height) : width{ width }, height{ height }, pixels(size_t(width) * height, SNULL), writes(size_t(width) * height, 0)
+  {
+    begin();
+  }
+
+  void SpriteRasterizer::begin(bool clear)
+  {
+    if (clear) { std::fill(pixels.begin(), pixels.end(), SNULL); }
+    std::fill(writes.begin(), writes.end(), 0);
+    stats = {};
+    boundTexture = nullptr;
+    bound = false;
+  }
+
+  void SpriteRasterizer::DrawSprite(const gef::Sprite& sprite, const gef::Matrix33& transform)
+  {
+    // Build the same quad gef would draw, a unit square placed by the transform
+    Maths::Affine2D placement;
+    placement.assignFrom(transform);
+    Maths::Region2D uv;
+    uv.left = sprite.uv_position().x;
+    uv.bottom = sprite.uv_position().y;
+    uv.right = uv.left + sprite.uv_width();
+    uv.top = uv.bottom + sprite.uv_height();
+
+    SpriteVertex corners[4];
+    writeQuad(placement, uv, corners);
+    drawQuads(corners, 1, sprite.texture());
+  }
+
+  void SpriteRasterizer::drawQuads(const SpriteVertex* vertices, size_t quadCount, const void* texture)
+  {
+    bindTexture(texture);
+    for (size_t i = 0; i < quadCount; ++i)
+    {
+      rasterQuad(vertices + i * 4);
+    }
+    stats.quads += static_cast<UInt>(quadCount);
+  }
+
+  void SpriteRasterizer::bindTexture(const void* texture)
+  {
+    if (!bound || texture != boundTexture)
+    {
+      ++stats.textureSwitches;
+      boundTexture = texture;
+      bound = true;
+    }
+  }
+
+  void SpriteRasterizer::rasterQuad(const SpriteVertex* corners)
+  {
+    // The quad is a parallelogram, so each pixel centre is solved for its (s, t) along the two edges from corner 0
+    const float ax = corners[1].x - corners[0].x, ay = corners[1].y - corners[0].y;
+    const float bx = corners[3].x - corners[0].x, by = corners[3].y - corners[0].y;
+    const float det = ax * by - ay * bx;
+    if (std::abs(det) < 1e-12f) { return; }
+    const float invDet = 1.f / det;
+
+    // Clip the bounds to the framebuffer
+    float minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+    for (int i = 1; i < 4; ++i)
+    {
+      minX = std::min(minX, corners[i].x); maxX = std::max(maxX, corners[i].x);
+      minY = std::min(minY, corners[i].y); maxY = std::max(maxY, corners[i].y);
+    }
+    const Int x0 = std::max(Int(std::floor(minX)), 0), x1 = std::min(Int(std::ceil(maxX)), Int(width));
+    const Int y0 = std::max(Int(std::floor(minY)), 0), y1 = std::min(Int(std::ceil(maxY)), Int(height));
+
+    const float du = corners[1].u - corners[0].u, dv = corners[3].v - corners[0].v;
+    const float sStep = by * invDet, tStep = -ay * invDet;
+    for (Int y = y0; y < y1; ++y)
+    {
+      const float dx = float(x0) + .5f - corners[0].x, dy = float(y) + .5f - corners[0].y;
+      float s = (dx * by - dy * bx) * invDet;
+      float t = (ax * dy - ay * dx) * invDet;
+      for (Int x = x0; x < x1; ++x, s += sStep, t += tStep)
+      {
+        // Half open, so quads sharing an edge never both claim a pixel
+        if (s < .0f || s >= 1.f || t < .0f || t >= 1.f) { continue; }
+
+        const size_t pixel = size_t(y) * width + x;
+        pixels[pixel] = packUnit(corners[0].u + s * du) | (packUnit(corners[0].v + t * dv) << 16);
+        if (writes[pixel]++ == 0) { ++stats.pixelsCovered; }
+        ++stats.pixelsWritten;
+      }
+    }
+  }
+}
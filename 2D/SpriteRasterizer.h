@@ -0,0 +1,55 @@
+#pragma once
+
+#include <graphics/sprite.h>
+#include <maths/matrix33.h>
+
+#include <vector>
+
+#include "../Defs.h"
+#include "TextureWorks.h"
+
+namespace Textures
+{
+  // Draw counts for the frame since begin
+  struct RasterStats
+  {
+    UInt quads;
+    UInt textureSwitches; // Includes the first bind of the frame
+    unsigned long long pixelsWritten;
+    unsigned long long pixelsCovered; // Distinct pixels written at least once
+
+    inline float getOverdraw() const { return pixelsCovered ? float(pixelsWritten) / float(pixelsCovered) : .0f; }
+  };
+
+  // Headless stand-in for gef::SpriteRenderer, so draw data can be checked and timed without a display.
+  // Sprite space maps one unit to one pixel. Texels are never sampled, each pixel instead records the
+  // interpolated UV as two 16 bit fixed point halves (u low, v high), which pins down both placement and mapping
+  class SpriteRasterizer
+  {
+    public:
+    SpriteRasterizer(UInt width, UInt height);
+
+    void begin(bool clear = true); // Starts a frame, resetting statistics and optionally clearing the framebuffer to SNULL
+
+    // Same signature as gef::SpriteRenderer, so render paths can target either
+    void DrawSprite(const gef::Sprite& sprite, const gef::Matrix33& transform);
+    void drawQuads(const SpriteVertex* vertices, size_t quadCount, const void* texture); // Quads as written by writeQuad
+
+    inline UInt getWidth() const { return width; }
+    inline UInt getHeight() const { return height; }
+    inline UInt getPixel(UInt x, UInt y) const { return pixels[y * width + x]; }
+    inline const std::vector<UInt>& getPixels() const { return pixels; }
+    inline const RasterStats& getStats() const { return stats; }
+
+    private:
+    void bindTexture(const void* texture);
+    void rasterQuad(const SpriteVertex* corners);
+
+    UInt width, height;
+    std::vector<UInt> pixels;
+    std::vector<UInt> writes; // Per pixel writes this frame, for overdraw
+    RasterStats stats;
+    const void* boundTexture;
+    bool bound;
+  };
+}
@@ -3,20 +3,15 @@
 #include "load_texture.h"
 namespace Textures
 {
-  TextureAtlas::TextureAtlas()
+  TextureAtlas::TextureAtlas(AssetArena* arena) : regions{ ArenaAllocator<RegionPack>(arena) }, baked{ false }
   {
-    regions = nullptr;
     tex = SNULL;
-  }
-
-  TextureAtlas::~TextureAtlas()
-  {
-    if (regions) { delete[] regions; regions = nullptr; }
+    subDivisions.setStatsName("Atlas divisions");
   }
 
   UInt TextureAtlas::addDivision(Label name, const SubTextureDesc& division)
   {
-    return subDivisions.add(name, { 0, division }).getHeapID();
+    return subDivisions.add(name, 0, division);
   }
 
   UInt TextureAtlas::getDivision(Label name) const
@@ -34,12 +29,8 @@ namespace Textures
     subDivisions = other.subDivisions;
     texDesc = other.texDesc;
     tex = other.tex;
-    if (regions) { delete[] regions; regions = nullptr; }
-    if (other.regions)
-    {
-      regions = new RegionPack[subDivisions.getHeapSize()];
-      std::memcpy(regions, other.regions, subDivisions.getHeapSize() * sizeof(RegionPack));
-    }
+    regions = other.regions; // Stays in this atlas' own arena
+    baked = other.baked;
 
     return *this;
   }
@@ -53,8 +44,7 @@ namespace Textures
   bool Textures::TextureAtlas::bake(const bool isSwizzled)
   {
     // Generate space for regions
-    if (regions) { delete[] regions; }
-    regions = new RegionPack[subDivisions.getHeapSize()];
+    regions.resize(subDivisions.getHeapSize());
 
     // Copy over normalised information per division
     {
@@ -62,18 +52,20 @@ namespace Textures
       float xNorm = 1 / float(texDesc.width);
       float yNorm = 1 / float(texDesc.height);
 
-      for (size_t i = 0; i < subDivisions.getHeapSize(); ++i)
-      {
-        auto& detailedDiv = subDivisions.get(i);
-        auto& subDiv = detailedDiv.subDesc;
+      const size_t divisionCount = subDivisions.getHeapSize();
+      const SubTextureDesc* subDescs = subDivisions.getColumn<DivisionDesc>();
+      UInt* regionIDs = subDivisions.getColumn<DivisionRegionID>();
 
-        if (!isSwizzled)
-        {
-          // Use the division order when lacking a preset order
-          detailedDiv.regionID = i;
-        }
+      if (!isSwizzled)
+      {
+        // Use the division order when lacking a preset order
+        for (size_t i = 0; i < divisionCount; ++i) { regionIDs[i] = static_cast<UInt>(i); }
+      }
 
-        RegionPack* progress = regions + detailedDiv.regionID;
+      for (size_t i = 0; i < divisionCount; ++i)
+      {
+        const SubTextureDesc& subDiv = subDescs[i];
+        RegionPack* progress = regions.data() + regionIDs[i];
 
         // UV space
         progress->uv.left = float(subDiv.x) * xNorm;
@@ -81,18 +73,20 @@ namespace Textures
         progress->uv.right = progress->uv.left + float(subDiv.width) * xNorm;
         progress->uv.top = progress->uv.bottom + float(subDiv.height) * yNorm;
         
-        // Sub sprite transform
+        // Sub sprite transform, written out directly as (scale * translation)
         {
-          gef::Matrix33 scaleMat = gef::Matrix33::kIdentity;
-          scaleMat.Scale(gef::Vector2(float(subDiv.width), float(subDiv.height)));
-
-          gef::Matrix33 translationMat = gef::Matrix33::kIdentity;
-          translationMat.SetTranslation(gef::Vector2(float(subDiv.width) * 0.5f - float(subDiv.displayWidth) * 0.5f - float(subDiv.displayX), float(subDiv.height) * 0.5f - float(subDiv.displayHeight) * 0.5f - float(subDiv.displayY)));
-
-          progress->transform = scaleMat * translationMat;
+          gef::Matrix33& transform = progress->transform;
+          transform.m[0][0] = float(subDiv.width); transform.m[0][1] = .0f; transform.m[0][2] = .0f;
+          transform.m[1][0] = .0f; transform.m[1][1] = float(subDiv.height); transform.m[1][2] = .0f;
+          transform.m[2][0] = float(subDiv.width) * 0.5f - float(subDiv.displayWidth) * 0.5f - float(subDiv.displayX);
+          transform.m[2][1] = float(subDiv.height) * 0.5f - float(subDiv.displayHeight) * 0.5f - float(subDiv.displayY);
+          transform.m[2][2] = 1.f;
         }
       }
     }
+    subDivisions.freeze();
+
+    baked = true;
     return isBaked();
   }
 
@@ -112,6 +106,15 @@ namespace Textures
     return resourceDesc.getHeapID();
   }
   
+  bool TextureCollection::remove(gef::StringId path)
+  {
+    UInt id = resourceMap.getID(path);
+    if (id == SNULL) { return false; }
+
+    delete resourceMap.get(id);
+    return resourceMap.remove(path);
+  }
+
   UInt TextureCollection::getTextureDesc(gef::StringId path, TextureDesc*& out)
   {
     if (auto resourceDesc = resourceMap.getMetaInfo(path))
@@ -126,17 +129,28 @@ namespace Textures
   void TextureCollection::loadAll(Path rootPath, gef::Platform& platform)
   {
     // Load each texture by stored path into a slot
-    for (const auto& namedResource : resourceMap.getNameMap())
+    resourceMap.inspectNames([&](gef::StringId pathID, const DetailedTexture& resourceDesc)
     {
-      auto& textureSlot = resourceMap.get(namedResource.second.getHeapID());
-      if (!textureSlot) 
+      auto& textureSlot = resourceMap.get(resourceDesc.getHeapID());
+      CString relativePath = StringTable.Find(pathID);
+      if (!textureSlot && relativePath) 
       {
-        std::string path;
-        StringTable.Find(namedResource.first, path);
-        path = rootPath + fsp + path;
+        std::string path = rootPath + fsp + relativePath;
         textureSlot = CreateTextureFromPNG(path.c_str(), platform);
       }
-    }
+    });
     baked = true;
   }
+
+  void writeQuad(const Maths::Affine2D& transform, const Maths::Region2D& uv, SpriteVertex* out)
+  {
+    // Half extents along each axis, the quad is centred on the transform's origin
+    const float ax = .5f * transform.m00, ay = .5f * transform.m01;
+    const float bx = .5f * transform.m10, by = .5f * transform.m11;
+
+    out[0] = { transform.m20 - ax - bx, transform.m21 - ay - by, uv.left, uv.bottom };
+    out[1] = { transform.m20 + ax - bx, transform.m21 + ay - by, uv.right, uv.bottom };
+    out[2] = { transform.m20 + ax + bx, transform.m21 + ay + by, uv.right, uv.top };
+    out[3] = { transform.m20 - ax + bx, transform.m21 - ay + by, uv.left, uv.top };
+  }
 }
\ No newline at end of file
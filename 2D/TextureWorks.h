@@ -27,6 +27,25 @@ namespace Textures
     Int displayWidth, displayHeight;
   };
 
+  // One corner of a transformed sprite quad, ready for a vertex buffer
+  struct SpriteVertex
+  {
+    float x, y;
+    float u, v;
+  };
+
+  // A run of quads sharing a texture, drawn with one submission. Quad q covers vertices [4q, 4q + 4)
+  struct SpriteBatch
+  {
+    UInt textureID; // Slot in the TextureCollection
+    UInt firstQuad;
+    UInt quadCount;
+  };
+
+  // Writes the four corners of a unit sprite quad placed by transform, as DrawSprite would.
+  // Corners go (-,-), (+,-), (+,+), (-,+) in local space, so triangles are {0, 1, 2} and {0, 2, 3}
+  void writeQuad(const Maths::Affine2D& transform, const Maths::Region2D& uv, SpriteVertex* out);
+
   // Contains texture resources (deferred load)
   class TextureCollection
   {
@@ -37,8 +56,11 @@ namespace Textures
     UInt add(Path path, const TextureDesc& desc);
     void loadAll(Path rootPath, gef::Platform& platform);
     UInt getTextureDesc(gef::StringId path, TextureDesc*& out);
+    bool remove(gef::StringId path); // Frees a single texture. The last texture takes over its ID, prefer handles across removals
 
+    inline NamedHeapHandle getTextureHandle(gef::StringId path) const { return resourceMap.getHandle(path); }
     inline const gef::Texture* getTextureData(UInt id) const { return resourceMap.get(id); }
+    inline const gef::Texture* getTextureData(NamedHeapHandle handle) const { auto texture = resourceMap.get(handle); return texture ? *texture : nullptr; }
     inline bool isBaked() const { return baked; }
 
     private:
@@ -61,12 +83,13 @@ namespace Textures
       gef::Matrix33 transform;
     };
 
-    TextureAtlas();
-    ~TextureAtlas();
+    typedef std::true_type uses_asset_arena;
+    explicit TextureAtlas(AssetArena* arena = nullptr); // Baked regions are allocated from the arena when given
 
     // SLOW //
     bool bake(const bool isSwizzled = false); // Generates parametrised data, optionally to a prescribed "regionID"
     UInt addDivision(Label name, const SubTextureDesc& division);
+    inline void reserveDivisions(size_t count) { subDivisions.reserve(count); }
     UInt getDivision(Label name) const;
     UInt getDivision(gef::StringId nameID) const;
     //
@@ -76,23 +99,24 @@ namespace Textures
     void setTexture(UInt textureID, const TextureDesc& desc);
 
     // This can be used to ascribe a more cache friendly ordering before baking!
-    inline void setRegionID(UInt divID, UInt regionID) { subDivisions.get(divID).regionID = regionID; }
+    inline void setRegionID(UInt divID, UInt regionID) { subDivisions.get<DivisionRegionID>(divID) = regionID; }
 
-    inline UInt getRegionID(UInt divID) const { return divID >= subDivisions.getHeapSize() ? SNULL : subDivisions.get(divID).regionID; }
-    inline bool isBaked() const { return regions != nullptr; }
+    inline UInt getRegionID(UInt divID) const { return divID >= subDivisions.getHeapSize() ? SNULL : subDivisions.get<DivisionRegionID>(divID); }
+    inline bool isBaked() const { return baked; }
     inline size_t getCount() const { return static_cast<UInt>(subDivisions.getHeapSize()); }
     inline UInt getTextureID() const { return tex; }
-    inline const RegionPack* getData(UInt id) const { return regions + id; }
+    inline const RegionPack* getData(UInt id) const { return regions.data() + id; }
     private:
-    struct DetailedDivision
+    enum DivisionColumn : size_t
     {
-      UInt regionID; // Used for sorting regions externally
-      SubTextureDesc subDesc;
+      DivisionRegionID = 0, // Used for sorting regions externally
+      DivisionDesc
     };
 
-    NamedHeap<DetailedDivision> subDivisions; // Maps sub division by name to ID
+    NamedHeapSoA<UInt, SubTextureDesc> subDivisions; // Maps sub division by name to ID. Split so region lookups do not drag descriptors through the cache
     TextureDesc texDesc;
     UInt tex; // Texture slot
-    RegionPack* regions; // Baked position information
+    ArenaVector<RegionPack> regions; // Baked position information
+    bool baked;
   };
 }
\ No newline at end of file
@@ -4,6 +4,7 @@ namespace Animation
 {
   SceneCollection::SceneCollection()
   {
+    scenes.setStatsName("Scenes");
   }
 
   SceneCollection::~SceneCollection()
@@ -17,6 +18,7 @@ namespace Animation
 
   gef::Scene* SceneCollection::getScene(Label name)
   {
+    std::lock_guard<std::mutex> guard(sceneLock);
     if (auto indexer = scenes.getMetaInfo(name))
     {
       return scenes.get(indexer->getHeapID());
@@ -25,13 +27,18 @@ namespace Animation
     return nullptr;
   }
 
-  void Animation::SceneCollection::registerScene(Label name, gef::Scene* scene)
+  gef::Scene* Animation::SceneCollection::registerScene(Label name, gef::Scene* scene)
   {
-    scenes.add(name, scene);
+    {
+      std::lock_guard<std::mutex> guard(sceneLock);
+      scene = scenes.get(scenes.add(name, scene).getHeapID());
+    }
+
     // Merge string table to global
     for (auto& it : scene->string_id_table.table())
     {
       StringTable.Add(it.second);
     }
+    return scene;
   }
 }
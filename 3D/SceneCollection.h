@@ -1,10 +1,11 @@
 #pragma once
 #include <graphics/scene.h>
+#include <mutex>
 #include "DataStructures.h"
 
 namespace Animation
 {
-  // Stores scene references
+  // Stores scene references. Safe to share between importer threads
   class SceneCollection
   {
     public:
@@ -12,9 +13,10 @@ namespace Animation
     ~SceneCollection();
 
     gef::Scene* getScene(Label name);
-    void registerScene(Label name, gef::Scene* scene);
+    gef::Scene* registerScene(Label name, gef::Scene* scene); // Returns the scene kept under this name, which may have been registered first by another thread
 
     private:
+    std::mutex sceneLock;
     NamedHeap<gef::Scene*> scenes;
   };
 
@@ -70,6 +70,7 @@ namespace Animation
 
   Skeleton3D::Skeleton3D() : skeleton{nullptr}, mesh{nullptr}
   {
+    animations.setStatsName("Skeleton3D animations");
   }
 
   void Skeleton3D::bindTo(Skeleton3D::Instance& inst)
@@ -117,6 +117,7 @@ namespace Animation
     void setSkeleton(const gef::Skeleton* newSkeleton);
     inline void setMesh(const gef::Mesh* newMesh) { mesh = newMesh; }
     UInt addAnimation(gef::StringId labelID, const gef::Animation* animation);
+    inline bool removeAnimation(gef::StringId labelID) { return animations.remove(labelID); } // The last animation takes over the freed ID
     UInt getAnimationID(Label label) const;
     UInt getAnimationID(gef::StringId labelID) const;
 
@@ -304,7 +304,7 @@ namespace BlendTree
 
   BlendNodePtr BlendTree::removeNode(Label name)
   {
-    return removeNode(StringTable.Add(name));;
+    return removeNode(gef::GetStringId(name));
   }
 
   BlendNodePtr BlendTree::removeNode(gef::StringId nameID)
@@ -14,7 +14,7 @@ namespace BlendTree
   #define ImplementGetterNode(Typename) NodeClassMeta Typename##GetterNode::get##Typename##ClassDescriptor; \
   void Typename##GetterNode::process(const BlendTree* tree, float dt)\
   {\
-    outputs[OutValueIdx] = (void*)tree->get##Typename(variableReferenceName); /* A bit slow. Could be improved...*/\
+    outputs[OutValueIdx] = (void*)tree->get##Typename(variableReferenceID);\
   }\
   void Typename##GetterNode::render()\
   {\
@@ -26,7 +26,10 @@ namespace BlendTree
       ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.f, .85f, .0f, 1.f));\
     }\
     ImGui::PushItemWidth(150.0f);\
-      ImGui::InputText("Param Name", &variableReferenceName);\
+      if (ImGui::InputText("Param Name", &variableReferenceName))\
+      {\
+        variableReferenceID = gef::GetStringId(variableReferenceName);\
+      }\
     ImGui::PopItemWidth();\
     if (outputs[OutValueIdx])\
     {\
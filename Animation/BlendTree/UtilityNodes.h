@@ -13,7 +13,8 @@ namespace BlendTree
   class Typename##GetterNode : public BlendNode\
   {\
     public:\
-    Typename##GetterNode(Label name, Label referenceName = "undefined") : BlendNode(name, &get##Typename##ClassDescriptor) { variableReferenceName = referenceName; }\
+    explicit Typename##GetterNode(Label name) : BlendNode(name, &get##Typename##ClassDescriptor) { variableReferenceName = "undefined"; variableReferenceID = "undefined"_sid; }\
+    Typename##GetterNode(Label name, Label referenceName) : BlendNode(name, &get##Typename##ClassDescriptor) { variableReferenceName = referenceName; variableReferenceID = gef::GetStringId(referenceName); }\
 \
     static void registerClass()\
     {\
@@ -34,6 +35,7 @@ namespace BlendTree
     private:\
     static NodeClassMeta get##Typename##ClassDescriptor;\
     std::string variableReferenceName;\
+    gef::StringId variableReferenceID; /* Hashed once per edit rather than per update */\
   };
 
   DeclareGetterNode(Bool, Param_Bool)
@@ -67,6 +67,7 @@ namespace IO
     if (!node.HasMember("bone")) { return false; }
     {
       auto bonesNode = node["bone"].GetArray();
+      out.reserveBones(bonesNode.Size());
       for (auto& boneNode : bonesNode)
       {
         if (!boneNode.HasMember("name")) { continue; }
@@ -87,6 +88,7 @@ namespace IO
     if (!node.HasMember("slot")) { return false; }
 
     auto slotsNode = node["slot"].GetArray();
+    out.reserveSlots(slotsNode.Size());
     for (auto& slotNode : slotsNode)
     {
       std::string name;
@@ -143,6 +145,7 @@ namespace IO
         if (boneNode.HasMember("translateFrame") && boneNode["translateFrame"].IsArray())
         {
           auto transNodes = boneNode["translateFrame"].GetArray();
+          out.reserveKeyframes(track, Animation::DopeSheet2D::AttributeTranslation, transNodes.Size());
           for (auto& transNode : transNodes)
           {
             float duration;
@@ -161,6 +164,7 @@ namespace IO
         if (boneNode.HasMember("rotateFrame") && boneNode["rotateFrame"].IsArray())
         {
           auto rotNodes = boneNode["rotateFrame"].GetArray();
+          out.reserveKeyframes(track, Animation::DopeSheet2D::AttributeRotation, rotNodes.Size());
           for (auto& rotNode : rotNodes)
           {
             float duration;
@@ -198,6 +202,7 @@ namespace IO
     if (armatureRootNode.HasMember("skin"))
     {
       auto skinsNode = armatureRootNode["skin"].GetArray();
+      out.reserveSkins(skinsNode.Size());
       for (auto& skinNode : skinsNode)
       {
         UInt skinID = out.addSkin();
@@ -212,6 +217,7 @@ namespace IO
       getValue(armatureRootNode, "frameRate", animFPS, 24.0f);
 
       auto animationNodes = armatureRootNode["animation"].GetArray();
+      out.reserveAnimations(animationNodes.Size());
       for (auto& animationNode : animationNodes)
       {
         float animDuration;
@@ -251,6 +257,7 @@ namespace IO
     if(json.HasMember("SubTexture"))
     {
       auto subArrayNode = json["SubTexture"].GetArray();
+      out.reserveDivisions(subArrayNode.Size());
       for (auto& subNode : subArrayNode)
       {
         SubTextureDesc subDesc;
@@ -281,6 +288,7 @@ namespace IO
 
     // Fetch the root armature
     auto armaturesNode = json["armature"].GetArray();
+    out.reserveAnimations(armaturesNode.Size());
     for (auto& armatureNode : armaturesNode)
     {
       float animFPS;
@@ -302,6 +310,7 @@ namespace IO
           if (slotNode.HasMember("display") && slotNode["display"].IsArray())
           {
             auto displaysNode = slotNode["display"].GetArray();
+            subtextureSequence.reserve(displaysNode.Size());
             for (auto& displayNode : displaysNode)
             {
               std::string subtextureName;
@@ -10,9 +10,12 @@ namespace IO
     gef::Scene* scene = scenes.getScene(path);
     if (scene == nullptr)
     {
-      scene = new gef::Scene();
-      scene->ReadSceneFromFile(platform, path);
-      scenes.registerScene(path, scene);
+      gef::Scene* loadedScene = new gef::Scene();
+      loadedScene->ReadSceneFromFile(platform, path);
+
+      // Another thread may have loaded the same file in the meantime
+      scene = scenes.registerScene(path, loadedScene);
+      if (scene != loadedScene) { delete loadedScene; }
     }
 
     if (!animationOnly)
@@ -58,9 +61,12 @@ namespace IO
     gef::Scene* scene = scenes.getScene(path);
     if (scene == nullptr)
     {
-      scene = new gef::Scene();
-      scene->ReadSceneFromFile(platform, path);
-      scenes.registerScene(path, scene);
+      gef::Scene* loadedScene = new gef::Scene();
+      loadedScene->ReadSceneFromFile(platform, path);
+
+      // Another thread may have loaded the same file in the meantime
+      scene = scenes.registerScene(path, loadedScene);
+      if (scene != loadedScene) { delete loadedScene; }
     }
 
     if (!scene->animations.empty())
@@ -5,6 +5,7 @@ namespace Animation
 {
   SpriteSheet::SpriteSheet()
   {
+    detailedAnimations.setStatsName("Sprite animations");
   }
 
   bool SpriteSheet::bake()
@@ -33,6 +34,7 @@ namespace Animation
       }
       detailedAnimation.bakedEndFrame = regionID;
     }
+    detailedAnimations.freeze();
 
     return atlas.bake(true);
   }
@@ -77,7 +79,7 @@ namespace Animation
     return regionID;
   }
 
-  SpriteInstance::SpriteInstance() : sheet{ nullptr }, currentAnimation{ SNULL }, playing{ false }, elapsedTime{.0f}
+  SpriteInstance::SpriteInstance() : sheet{ nullptr }, currentAnimation{ SNULL }, playing{ false }, elapsedTime{.0f}, culled{ false }, animationCulled{ false }
   {
     globalTransform.SetIdentity();
     spriteTransform.SetIdentity();
@@ -85,14 +87,22 @@ namespace Animation
 
   void SpriteInstance::render(gef::SpriteRenderer* renderer)
   {
+    if (culled) { return; }
     renderer->DrawSprite(sprite, spriteTransform * globalTransform);
   }
 
+  void SpriteInstance::render(Textures::SpriteRasterizer* rasterizer)
+  {
+    if (culled) { return; }
+    rasterizer->DrawSprite(sprite, spriteTransform * globalTransform);
+  }
+
   void SpriteInstance::update(float dt)
   {
     if (playing && sheet && currentAnimation < sheet->getAnimationCount())
     {
       elapsedTime += dt;
+      if (animationCulled) { return; }
 
       // Update the sprite transform and UV data based on animation cycle
       UInt frameRegionID = sheet->getAnimationFrameID(currentAnimation, elapsedTime);
@@ -106,6 +116,21 @@ namespace Animation
     }
   }
 
+  bool SpriteInstance::cull(const Maths::Region2D& view, bool pauseAnimation)
+  {
+    culled = !Maths::overlaps(getBounds(), view);
+    animationCulled = culled && pauseAnimation;
+    return !culled;
+  }
+
+  Maths::Region2D SpriteInstance::getBounds() const
+  {
+    // Sprites are unit quads placed by their transform
+    Maths::Affine2D placement;
+    placement.assignFrom(spriteTransform * globalTransform);
+    return Maths::transformBounds({ .5f, -.5f, -.5f, .5f }, placement);
+  }
+
   void SpriteInstance::play(UInt animID)
   {
     currentAnimation = animID;
@@ -3,6 +3,7 @@
 #include <graphics/sprite_renderer.h>
 
 #include "2D/TextureWorks.h"
+#include "2D/SpriteRasterizer.h"
 
 namespace Animation
 {
@@ -22,6 +23,7 @@ namespace Animation
     // Slow
     bool bake();
     UInt addAnimation(Label name, const std::vector<gef::StringId>& frameNames, float fps = 60.f);
+    inline void reserveAnimations(size_t count) { detailedAnimations.reserve(count); }
     UInt getAnimationID(Label name) const;
     //
 
@@ -48,15 +50,21 @@ namespace Animation
     inline void setSheet(SpriteSheet* spriteSheet) { sheet = spriteSheet; }
 
     void render(gef::SpriteRenderer* renderer);
+    void render(Textures::SpriteRasterizer* rasterizer); // Headless
     void update(float dt);
 
     void play(UInt animID);
+    // Tests the bounds against a view, returning visibility. Culled sprites are not rendered, and with
+    // pauseAnimation their frame is not updated until visible again, though the clock keeps running
+    bool cull(const Maths::Region2D& view, bool pauseAnimation = false);
+    Maths::Region2D getBounds() const; // World extent of the current frame
     void setTexture(Textures::TextureCollection& texCollection);
     inline void setGlobalTransform(const gef::Matrix33& newTransform) { globalTransform = newTransform; }
     inline void setPlaying(bool play) { playing = play; }
     inline bool getPlaying() const { return playing; }
     inline UInt getCurrentAnim() const { return currentAnimation; }
     inline const SpriteSheet* getSheet() const { return sheet; }
+    inline bool isCulled() const { return culled; }
 
     private:
     gef::Sprite sprite;
@@ -67,5 +75,7 @@ namespace Animation
     UInt currentAnimation;
     float elapsedTime;
     bool playing;
+    bool culled;
+    bool animationCulled; // Culled with frame updates paused
   };
 }
\ No newline at end of file
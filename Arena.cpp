@@ -0,0 +1,75 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+AssetArena::AssetArena(size_t initialSize) : blocks{ nullptr }, cursor{ nullptr }, limit{ nullptr }, nextBlockSize{ initialSize }, initialBlockSize{ initialSize }, used{ 0 }, reserved{ 0 }, blockCount{ 0 }
+{
+}
+
+AssetArena::~AssetArena()
+{
+  release();
+}
+
+void* AssetArena::allocate(size_t size, size_t alignment)
+{
+  auto align = [&](Byte* ptr) { return reinterpret_cast<Byte*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) & ~uintptr_t(alignment - 1)); };
+
+  Byte* start = cursor ? align(cursor) : nullptr;
+  if (!start || start + size > limit)
+  {
+    pushBlock(size + alignment);
+    start = align(cursor);
+  }
+
+  cursor = start + size;
+  used += size;
+  return start;
+}
+
+void AssetArena::release()
+{
+  while (blocks)
+  {
+    Block* next = blocks->next;
+    ::operator delete(blocks);
+    blocks = next;
+  }
+
+  cursor = limit = nullptr;
+  nextBlockSize = initialBlockSize;
+  used = reserved = blockCount = 0;
+}
+
+void AssetArena::pushBlock(size_t minSize)
+{
+  size_t blockSize = nextBlockSize;
+  while (blockSize < minSize + sizeof(Block)) { blockSize <<= 1; }
+  nextBlockSize = blockSize << 1;
+
+  Block* block = static_cast<Block*>(::operator new(blockSize));
+  block->next = blocks;
+  block->size = blockSize;
+  blocks = block;
+
+  cursor = reinterpret_cast<Byte*>(block + 1);
+  limit = reinterpret_cast<Byte*>(block) + blockSize;
+  reserved += blockSize;
+  ++blockCount;
+}
+
+std::unique_ptr<Byte[]> BlockWriter::finish()
+{
+  std::unique_ptr<Byte[]> block(new Byte[bytes.size()]);
+  std::copy(bytes.begin(), bytes.end(), block.get());
+  bytes = std::vector<Byte>();
+  return block;
+}
+
+void* BlockWriter::copyTo(AssetArena& arena) const
+{
+  void* block = arena.allocate(bytes.size(), alignof(std::max_align_t));
+  std::copy(bytes.begin(), bytes.end(), static_cast<Byte*>(block));
+  return block;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Defs.h"
+
+// Monotonic per-asset memory. Allocations bump a cursor through a handful of growing blocks and are only ever
+// freed together, so unloading an asset is a single release
+class AssetArena
+{
+  public:
+  explicit AssetArena(size_t initialBlockSize = 64 * 1024);
+  ~AssetArena();
+  AssetArena(const AssetArena&) = delete;
+  AssetArena& operator=(const AssetArena&) = delete;
+
+  void* allocate(size_t size, size_t alignment);
+  void release(); // Frees every block. Anything still pointing into the arena is left dangling!
+
+  inline size_t getUsed() const { return used; }
+  inline size_t getReserved() const { return reserved; }
+  inline size_t getBlockCount() const { return blockCount; }
+
+  private:
+  struct Block
+  {
+    Block* next;
+    size_t size;
+  };
+
+  void pushBlock(size_t minSize);
+
+  Block* blocks; // Most recent first
+  Byte* cursor;
+  Byte* limit;
+  size_t nextBlockSize; // Doubles per block to keep the count low
+  size_t initialBlockSize;
+  size_t used;
+  size_t reserved;
+  size_t blockCount;
+};
+
+// Types opt in to receiving their container's arena by declaring "typedef std::true_type uses_asset_arena;"
+template<typename T, typename = void> struct UsesAssetArena : std::false_type {};
+template<typename T> struct UsesAssetArena<T, std::void_t<typename T::uses_asset_arena>> : T::uses_asset_arena {};
+
+// Standard allocator over an optional arena. Without an arena it falls back to the global heap.
+// Element types that opt in through UsesAssetArena are constructed as (args..., AssetArena*) where they can be, so
+// nested containers follow their parent. Nothing else is ever handed the arena, whatever its constructors accept
+template<typename T> class ArenaAllocator
+{
+  public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  ArenaAllocator(AssetArena* owner = nullptr) noexcept : arena{ owner } {}
+  template<typename U> ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena{ other.getArena() } {}
+
+  T* allocate(size_t count)
+  {
+    return static_cast<T*>(arena ? arena->allocate(count * sizeof(T), alignof(T)) : ::operator new(count * sizeof(T)));
+  }
+  void deallocate(T* ptr, size_t) noexcept
+  {
+    if (!arena) { ::operator delete(ptr); } // Arena memory goes with the arena
+  }
+
+  template<typename U, typename... Args> void construct(U* ptr, Args&&... args)
+  {
+    if constexpr (UsesAssetArena<U>::value && std::is_constructible<U, Args..., AssetArena*>::value)
+    {
+      ::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)..., arena);
+    }
+    else
+    {
+      ::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+    }
+  }
+
+  inline AssetArena* getArena() const { return arena; }
+
+  template<typename U> bool operator==(const ArenaAllocator<U>& other) const { return arena == other.getArena(); }
+  template<typename U> bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.getArena(); }
+
+  private:
+  AssetArena* arena;
+};
+
+template<typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+template<typename T> using ArenaList = std::list<T, ArenaAllocator<T>>;
+
+// Array held at a byte offset from itself rather than by pointer, so a block containing both it and its elements
+// can be moved or copied as raw bytes. Only ever laid out by BlockWriter
+template<typename T> class RelativeArray
+{
+  friend class BlockWriter;
+  public:
+  inline size_t size() const { return count; }
+  inline bool empty() const { return !count; }
+  inline const T* data() const { return reinterpret_cast<const T*>(reinterpret_cast<const Byte*>(this) + offset); }
+  inline const T* begin() const { return data(); }
+  inline const T* end() const { return data() + count; }
+  inline const T& operator[](size_t idx) const { return data()[idx]; }
+  inline const T& back() const { return data()[count - 1]; }
+
+  private:
+  Int offset; // Bytes from this array to its first element
+  UInt count;
+};
+
+// Lays out a relocatable block of plain data. The buffer moves as it grows, so space is handed out as offsets and
+// references from at() only last until the next claim
+class BlockWriter
+{
+  public:
+  template<typename T> size_t claim(size_t count = 1) // Zeroed space for count of T, returns its offset
+  {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Blocks are only aligned for fundamental types");
+    const size_t start = (bytes.size() + alignof(T) - 1) & ~(alignof(T) - 1);
+    bytes.resize(start + count * sizeof(T));
+    return start;
+  }
+  template<typename T> size_t append(const T* values, size_t count) // Copies values to the end of the block, returns their offset
+  {
+    const size_t start = claim<T>(count);
+    if (count) { std::memcpy(bytes.data() + start, values, count * sizeof(T)); }
+    return start;
+  }
+  template<typename T> inline T& at(size_t offset) { return *reinterpret_cast<T*>(bytes.data() + offset); }
+  template<typename T> void link(RelativeArray<T>& array, size_t elementsOffset, size_t count) // Array must be inside this block
+  {
+    array.offset = static_cast<Int>(static_cast<ptrdiff_t>(elementsOffset) - (reinterpret_cast<Byte*>(&array) - bytes.data()));
+    array.count = static_cast<UInt>(count);
+  }
+
+  inline size_t getSize() const { return bytes.size(); }
+
+  std::unique_ptr<Byte[]> finish(); // Hands over the block as one allocation, leaving the writer empty
+  void* copyTo(AssetArena& arena) const; // Copies the block into the arena as one allocation
+
+  private:
+  std::vector<Byte> bytes;
+};
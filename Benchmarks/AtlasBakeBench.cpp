@@ -0,0 +1,112 @@
+// The TextureAtlas::bake pass over 10k divisions, with divisions held in a NamedHeap of whole records against the
+// NamedHeapSoA columns the atlas uses, plus the real bake for reference. Both heaps are frozen and uninstrumented.
+// Build with the 2D folder, DataStructures.cpp, Arena.cpp, Globals.cpp, HeapStats.cpp, StringInterner.cpp, MappedFile.cpp and gef
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "../2D/TextureWorks.h"
+
+namespace
+{
+  using Textures::SubTextureDesc;
+  using RegionPack = Textures::TextureAtlas::RegionPack;
+
+  // Division record as a single heap stores it
+  struct Division
+  {
+    UInt regionID;
+    SubTextureDesc desc;
+  };
+
+  constexpr Textures::TextureDesc atlasDesc = { 4096, 4096 };
+
+  inline SubTextureDesc makeDivision(size_t i)
+  {
+    const UInt x = static_cast<UInt>(i % 128) * 32, y = static_cast<UInt>(i / 128) * 32;
+    return { x, y, 32, 32, Int(i % 5), Int(i % 3), 34, 36 };
+  }
+
+  // Same per-division work as TextureAtlas::bake
+  inline void bakeRegion(const SubTextureDesc& subDiv, RegionPack& region, float xNorm, float yNorm)
+  {
+    region.uv.left = float(subDiv.x) * xNorm;
+    region.uv.bottom = float(subDiv.y) * yNorm;
+    region.uv.right = region.uv.left + float(subDiv.width) * xNorm;
+    region.uv.top = region.uv.bottom + float(subDiv.height) * yNorm;
+
+    gef::Matrix33& transform = region.transform;
+    transform.m[0][0] = float(subDiv.width); transform.m[0][1] = .0f; transform.m[0][2] = .0f;
+    transform.m[1][0] = .0f; transform.m[1][1] = float(subDiv.height); transform.m[1][2] = .0f;
+    transform.m[2][0] = float(subDiv.width) * 0.5f - float(subDiv.displayWidth) * 0.5f - float(subDiv.displayX);
+    transform.m[2][1] = float(subDiv.height) * 0.5f - float(subDiv.displayHeight) * 0.5f - float(subDiv.displayY);
+    transform.m[2][2] = 1.f;
+  }
+
+  void report(const char* layout, size_t count, double bakeTime)
+  {
+    std::printf("%-18s %6zu divisions   %6.2f ns/division   %7.3f ms/bake\n", layout, count, bakeTime, bakeTime * double(count) * 1e-6);
+  }
+
+  void benchRecords(size_t count)
+  {
+    NamedHeap<Division, NamedHeapInfo, FlatIndex, NoHeapStats> divisions;
+    divisions.reserve(count);
+    for (size_t i = 0; i < count; ++i) { divisions.add(gef::GetStringId("division" + std::to_string(i)), { 0, makeDivision(i) }); }
+    divisions.freeze();
+
+    std::vector<RegionPack> regions(count);
+    const float xNorm = 1 / float(atlasDesc.width), yNorm = 1 / float(atlasDesc.height);
+    const double bakeTime = Bench::timeBest(count, [&]()
+    {
+      for (UInt i = 0; i < count; ++i) { divisions.get(i).regionID = i; }
+      for (UInt i = 0; i < count; ++i)
+      {
+        const Division& division = divisions.get(i);
+        bakeRegion(division.desc, regions[division.regionID], xNorm, yNorm);
+      }
+      Bench::sink = Bench::sink + UInt(regions[count / 2].transform.m[2][0]);
+    }, 20);
+    report("NamedHeap records", count, bakeTime);
+  }
+
+  void benchColumns(size_t count)
+  {
+    BasicNamedHeapSoA<FlatIndex, NoHeapStats, UInt, SubTextureDesc> divisions;
+    divisions.reserve(count);
+    for (size_t i = 0; i < count; ++i) { divisions.add(gef::GetStringId("division" + std::to_string(i)), 0, makeDivision(i)); }
+    divisions.freeze();
+
+    std::vector<RegionPack> regions(count);
+    const float xNorm = 1 / float(atlasDesc.width), yNorm = 1 / float(atlasDesc.height);
+    const double bakeTime = Bench::timeBest(count, [&]()
+    {
+      UInt* regionIDs = divisions.getColumn<0>();
+      const SubTextureDesc* descs = divisions.getColumn<1>();
+      for (UInt i = 0; i < count; ++i) { regionIDs[i] = i; }
+      for (size_t i = 0; i < count; ++i) { bakeRegion(descs[i], regions[regionIDs[i]], xNorm, yNorm); }
+      Bench::sink = Bench::sink + UInt(regions[count / 2].transform.m[2][0]);
+    }, 20);
+    report("NamedHeapSoA", count, bakeTime);
+  }
+
+  void benchAtlas(size_t count)
+  {
+    Textures::TextureAtlas atlas;
+    atlas.setTexture(0, atlasDesc);
+    atlas.reserveDivisions(count);
+    for (size_t i = 0; i < count; ++i) { atlas.addDivision("division" + std::to_string(i), makeDivision(i)); }
+
+    const double bakeTime = Bench::timeBest(count, [&]() { Bench::sink = Bench::sink + (atlas.bake() ? 1 : 0); }, 20);
+    report("TextureAtlas::bake", count, bakeTime);
+  }
+}
+
+int main()
+{
+  const size_t divisionCount = 10000;
+  benchRecords(divisionCount);
+  benchColumns(divisionCount);
+  benchAtlas(divisionCount);
+  return 0;
+}
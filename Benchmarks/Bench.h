@@ -0,0 +1,27 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "../Defs.h"
+
+// Shared helpers for the standalone benchmark programs in this folder. Each is a console program built against the
+// engine sources it names and gef, with optimisations on
+namespace Bench
+{
+  inline volatile UInt sink = 0; // Results are folded in here so the work being timed cannot be optimised away
+
+  // Best of several runs, in nanoseconds per operation. The best run is the one least disturbed by the rest of the system
+  template<typename Func> double timeBest(size_t operations, const Func& func, int runs = 5)
+  {
+    double best = 1e300;
+    for (int run = 0; run < runs; ++run)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      func();
+      const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      best = std::min(best, elapsed / double(operations));
+    }
+    return best;
+  }
+}
@@ -0,0 +1,54 @@
+// Name lookups through NamedHeap's MapIndex and FlatIndex, at the sizes bones, slots and atlas divisions reach.
+// Build with DataStructures.cpp, Arena.cpp, Globals.cpp, HeapStats.cpp, StringInterner.cpp and gef
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Bench.h"
+#include "../DataStructures.h"
+
+namespace
+{
+  template<template<typename> class Index> void benchIndex(const char* indexName, const char* usage, size_t count)
+  {
+    NamedHeap<UInt, NamedHeapInfo, Index> heap;
+    std::vector<gef::StringId> hits, misses;
+    for (size_t i = 0; i < count; ++i)
+    {
+      hits.push_back(gef::GetStringId(std::string(usage) + std::to_string(i)));
+      misses.push_back(gef::GetStringId(std::string(usage) + "Missing" + std::to_string(i)));
+      heap.add(hits.back(), static_cast<UInt>(i));
+    }
+
+    // Look names up out of insertion order, as a scene does
+    std::mt19937 random(7);
+    std::shuffle(hits.begin(), hits.end(), random);
+
+    const size_t rounds = std::max<size_t>(1, 2000000 / count);
+    auto lookUp = [&](const std::vector<gef::StringId>& names)
+    {
+      UInt total = 0;
+      for (size_t round = 0; round < rounds; ++round)
+      {
+        for (gef::StringId name : names) { total += heap.getID(name); }
+      }
+      Bench::sink = Bench::sink + total;
+    };
+    const double hitTime = Bench::timeBest(rounds * count, [&]() { lookUp(hits); });
+    const double missTime = Bench::timeBest(rounds * count, [&]() { lookUp(misses); });
+    std::printf("%-6s %-5s %6zu names   hit %6.2f ns   miss %6.2f ns\n", usage, indexName, count, hitTime, missTime);
+  }
+}
+
+int main()
+{
+  // Typical rig bone and slot counts, and a large shared atlas
+  const std::pair<const char*, size_t> sizes[] = { { "bone", 64 }, { "slot", 96 }, { "atlas", 4096 } };
+  for (auto& size : sizes)
+  {
+    benchIndex<MapIndex>("map", size.first, size.second);
+    benchIndex<FlatIndex>("flat", size.first, size.second);
+  }
+  return 0;
+}
@@ -0,0 +1,40 @@
+// Skeleton2D::bake over 100k bones, as a deep chain and as a wide tree, in both bone orders.
+// Build with the 2D folder, DataStructures.cpp, Arena.cpp, Globals.cpp, HeapStats.cpp, StringInterner.cpp, MappedFile.cpp and gef
+#include <string>
+
+#include "Bench.h"
+#include "../2D/Skeleton2D.h"
+
+namespace
+{
+  enum class Shape { Chain, Wide };
+
+  void benchBake(Shape shape, Animation::Skeleton2D::BoneOrder order, size_t boneCount)
+  {
+    // Every bone parents the next in a chain, while the wide tree hangs all of them off the root
+    Animation::Skeleton2D skeleton;
+    skeleton.reserveBones(boneCount);
+    for (size_t i = 0; i < boneCount; ++i)
+    {
+      auto& bone = skeleton.addBone("bone" + std::to_string(i));
+      if (i) { bone.parentName = "bone" + std::to_string(shape == Shape::Chain ? i - 1 : 0); }
+    }
+
+    bool baked = true;
+    const double boneTime = Bench::timeBest(boneCount, [&]() { baked = skeleton.bake(order) && baked; }, 3);
+    std::printf("%-5s %-13s %6zu bones   %7.2f ms   %5.1f ns/bone%s\n", shape == Shape::Chain ? "chain" : "wide",
+      order == Animation::Skeleton2D::BoneOrder::DepthFirst ? "depth-first" : "breadth-first", boneCount,
+      boneTime * double(boneCount) * 1e-6, boneTime, baked ? "" : "   (bake failed)");
+  }
+}
+
+int main()
+{
+  const size_t boneCount = 100000;
+  for (Shape shape : { Shape::Chain, Shape::Wide })
+  {
+    benchBake(shape, Animation::Skeleton2D::BoneOrder::DepthFirst, boneCount);
+    benchBake(shape, Animation::Skeleton2D::BoneOrder::BreadthFirst, boneCount);
+  }
+  return 0;
+}
@@ -1,5 +1,7 @@
 #include "DataStructures.h"
 
+#include <algorithm>
+
 
 NamedHeapInfo::NamedHeapInfo() : collectionID{SNULL}
 {
@@ -8,4 +10,73 @@ NamedHeapInfo::NamedHeapInfo() : collectionID{SNULL}
 void NamedHeapInfo::setHeapID(UInt id)
 {
   collectionID = id;
-}
\ No newline at end of file
+}
+
+PerfectHash::PerfectHash() : bucketCount{ 0 }, slotCount{ 0 }
+{
+}
+
+bool PerfectHash::build(const std::vector<gef::StringId>& names)
+{
+  clear();
+  if (names.empty()) { return false; }
+
+  slotCount = static_cast<UInt>(names.size());
+
+  // Roughly two names per bucket, growing the bucket count if the seed search stalls
+  for (bucketCount = (slotCount + 1) / 2; bucketCount <= slotCount * 4; bucketCount *= 2)
+  {
+    // Distribute names into buckets
+    std::vector<std::vector<gef::StringId>> buckets(bucketCount);
+    for (auto nameHash : names)
+    {
+      buckets[range(mix(nameHash, 0), bucketCount)].push_back(nameHash);
+    }
+
+    // Place the most crowded buckets first while the table is emptiest
+    std::vector<UInt> bucketOrder(bucketCount);
+    for (UInt i = 0; i < bucketCount; ++i) { bucketOrder[i] = i; }
+    std::sort(bucketOrder.begin(), bucketOrder.end(), [&](UInt a, UInt b) { return buckets[a].size() > buckets[b].size(); });
+
+    seeds.assign(bucketCount, 0);
+    std::vector<bool> taken(slotCount, false);
+    std::vector<UInt> trial;
+    bool success = true;
+    for (UInt bucketID : bucketOrder)
+    {
+      auto& bucket = buckets[bucketID];
+      if (bucket.empty()) { break; } // Sorted, so the rest are empty too
+
+      // Search for a seed that scatters the whole bucket into free slots
+      UInt seed = 1;
+      for (; seed < maxSeedAttempts; ++seed)
+      {
+        trial.clear();
+        for (auto nameHash : bucket)
+        {
+          UInt slotID = range(mix(nameHash, seed), slotCount);
+          if (taken[slotID] || std::find(trial.begin(), trial.end(), slotID) != trial.end()) { break; }
+          trial.push_back(slotID);
+        }
+        if (trial.size() == bucket.size()) { break; }
+      }
+
+      if (seed == maxSeedAttempts) { success = false; break; }
+
+      seeds[bucketID] = seed;
+      for (UInt slotID : trial) { taken[slotID] = true; }
+    }
+
+    if (success) { return true; }
+  }
+
+  clear();
+  return false;
+}
+
+void PerfectHash::clear()
+{
+  seeds.clear();
+  bucketCount = 0;
+  slotCount = 0;
+}
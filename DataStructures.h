@@ -1,9 +1,16 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "Arena.h"
 #include "Defs.h"
 #include "Globals.h"
+#include "HeapStats.h"
 
 // Package of metadata related to a heaped item which should not occupy the heap itself
 class NamedHeapInfo
@@ -18,22 +25,201 @@ class NamedHeapInfo
   UInt collectionID; // The element in the heap this structure refers to
 };
 
-// A heap of data with associated string key metadata
-template<typename Data, typename Indexer = NamedHeapInfo> class NamedHeap
+// Default name index, hashed buckets. Entry pointers are only promised until the next insert, as with FlatIndex
+template<typename Indexer> class MapIndex
+{
+  public:
+  MapIndex() = default;
+
+  void clear() { nameMap.clear(); }
+  void reserve(size_t count) { nameMap.reserve(count); }
+  std::pair<Indexer*, bool> insert(gef::StringId nameHash); // Finds or default constructs an entry. Second is true when fresh. Valid until the next insert
+  bool erase(gef::StringId nameHash) { return nameMap.erase(nameHash) != 0; }
+
+  Indexer* find(gef::StringId nameHash);
+  const Indexer* find(gef::StringId nameHash) const;
+  const Indexer* find(gef::StringId nameHash, UInt& probes) const { probes = 1; return find(nameHash); } // Bucket chains are not exposed
+  inline size_t size() const { return nameMap.size(); }
+  inline size_t capacity() const { return nameMap.bucket_count(); }
+
+  template<typename Func> void inspect(const Func& itFunc) const { for (auto& it : nameMap) { itFunc(it.first, it.second); } }
+
+  private:
+  std::unordered_map<gef::StringId, Indexer> nameMap;
+};
+
+// Cache friendly name index. Robin Hood probing over a flat array of name/indexer pairs.
+// References are invalidated on insertion, so do not hold onto them across adds!
+template<typename Indexer> class FlatIndex
+{
+  public:
+  FlatIndex() : count{ 0 }, shift{ 32 } {}
+
+  void clear();
+  void reserve(size_t count);
+  std::pair<Indexer*, bool> insert(gef::StringId nameHash); // Finds or default constructs an entry. Second is true when fresh. Valid until the next insert
+  bool erase(gef::StringId nameHash);
+
+  Indexer* find(gef::StringId nameHash) { return const_cast<Indexer*>(static_cast<const FlatIndex*>(this)->find(nameHash)); }
+  const Indexer* find(gef::StringId nameHash) const { UInt idx = locate(nameHash); return idx == SNULL ? nullptr : &slots[idx].info; }
+  const Indexer* find(gef::StringId nameHash, UInt& probes) const { UInt idx = locate(nameHash, &probes); return idx == SNULL ? nullptr : &slots[idx].info; }
+  inline size_t size() const { return count; }
+  inline size_t capacity() const { return slots.size(); }
+
+  template<typename Func> void inspect(const Func& itFunc) const { for (auto& slot : slots) { if (slot.distance) { itFunc(slot.nameHash, slot.info); } } }
+
+  private:
+  struct Slot
+  {
+    gef::StringId nameHash;
+    UInt distance; // Probe length + 1. Zero marks an empty slot
+    Indexer info;
+  };
+
+  // StringIds are already hashes, Fibonacci scrambling just spreads poor low bits
+  inline UInt home(gef::StringId nameHash) const { return static_cast<UInt>((static_cast<UInt>(nameHash) * 2654435769u) >> shift); }
+  UInt locate(gef::StringId nameHash, UInt* probes = nullptr) const; // Slot holding the name, or SNULL
+  void rehash(size_t capacity);
+  Indexer* place(Slot&& incoming); // Robin Hood insert of a known fresh name, returns where it landed
+
+  std::vector<Slot> slots; // Power of two sized
+  size_t count;
+  Byte shift; // 32 - log2(capacity)
+};
+
+// Minimal perfect hash over a fixed set of names (hash and displace). Every name maps to a unique slot in [0, n)
+class PerfectHash
+{
+  public:
+  PerfectHash();
+
+  bool build(const std::vector<gef::StringId>& names); // Searches displacement seeds for the name set
+  void clear();
+
+  // Only meaningful for names in the built set, anything else lands on an arbitrary slot
+  inline UInt slot(gef::StringId nameHash) const { return slot(nameHash, seeds.data(), bucketCount, slotCount); }
+  static inline UInt slot(gef::StringId nameHash, const UInt* seeds, UInt bucketCount, UInt slotCount) // For hashes stored elsewhere, e.g. snapshots
+  {
+    UInt seed = seeds[range(mix(nameHash, 0), bucketCount)];
+    return range(mix(nameHash, seed), slotCount);
+  }
+  inline size_t size() const { return slotCount; }
+  inline UInt getBucketCount() const { return bucketCount; }
+  inline const UInt* getSeeds() const { return seeds.data(); }
+
+  private:
+  static inline UInt mix(UInt key, UInt seed)
+  {
+    // Murmur3 finaliser
+    key ^= seed * 0x9E3779B9u;
+    key ^= key >> 16; key *= 0x85EBCA6Bu;
+    key ^= key >> 13; key *= 0xC2B2AE35u;
+    key ^= key >> 16;
+    return key;
+  }
+  static inline UInt range(UInt hash, UInt count) { return static_cast<UInt>((static_cast<unsigned long long>(hash) * count) >> 32); } // Avoids a modulo
+
+  static constexpr UInt maxSeedAttempts = 1 << 16;
+
+  std::vector<UInt> seeds; // Displacement per bucket
+  UInt bucketCount;
+  UInt slotCount;
+};
+
+// Read-only name index built once over another index. Lookups are a single slot compare with no probing
+template<typename Indexer> class PerfectIndex
+{
+  public:
+  PerfectIndex() = default;
+
+  template<typename Source> void build(const Source& index);
+  void clear() { hash.clear(); slots.clear(); }
+
+  Indexer* find(gef::StringId nameHash) { return const_cast<Indexer*>(static_cast<const PerfectIndex*>(this)->find(nameHash)); }
+  const Indexer* find(gef::StringId nameHash) const
+  {
+    if (slots.empty()) { return nullptr; }
+    const Slot& slot = slots[hash.slot(nameHash)];
+    return slot.nameHash == nameHash ? &slot.info : nullptr;
+  }
+  const Indexer* find(gef::StringId nameHash, UInt& probes) const { probes = slots.empty() ? 0 : 1; return find(nameHash); }
+  inline size_t size() const { return slots.size(); }
+
+  template<typename Func> void inspect(const Func& itFunc) const { for (auto& slot : slots) { itFunc(slot.nameHash, slot.info); } }
+
+  private:
+  struct Slot
+  {
+    gef::StringId nameHash;
+    Indexer info;
+  };
+
+  PerfectHash hash;
+  std::vector<Slot> slots;
+};
+
+// Stable reference to a heaped item which survives removal of other items. Detects reuse of its slot
+struct NamedHeapHandle
+{
+  UInt slot = SNULL;
+  UInt generation = 0;
+};
+
+// Layout of a NamedHeap snapshot. Every section is addressed by offset so the blob is position independent
+struct NamedHeapSnapshotHeader
+{
+  static constexpr UInt magicID = 0x50484E53; // "SNHP"
+  static constexpr UInt latestVersion = 1;
+
+  UInt magic;
+  UInt version;
+  UInt count; // Items, also the perfect hash slot count
+  UInt stride; // sizeof(Data) at write time
+  UInt bucketCount;
+  UInt seedsOffset; // UInt[bucketCount]
+  UInt namesOffset; // gef::StringId[count], by hash slot
+  UInt idsOffset; // UInt[count], by hash slot
+  UInt dataOffset; // Data[count], by heap ID
+  UInt totalSize;
+};
+
+// A heap of data with associated string key metadata. Stats is an instrumentation policy from HeapStats.h
+template<typename Data, typename Indexer = NamedHeapInfo, template<typename> class Index = MapIndex, typename Stats = DefaultHeapStats> class NamedHeap
 {
   static_assert(std::is_base_of<NamedHeapInfo, Indexer>::value, "Indexer must derive from NamedHeapInfo");
 
   public:
-  NamedHeap() = default;
+  typedef std::true_type uses_asset_arena;
+  explicit NamedHeap(AssetArena* arena = nullptr) : heapedData{ ArenaAllocator<Data>(arena) }, frozen{ false } {}
 
   void clear();
+  void reserve(size_t count); // Total capacity, avoids regrowing data and index during imports
+
+  // Swaps the name index for a perfect hash once the name set is final. Any add will thaw
+  void freeze();
+  void thaw();
+  inline bool isFrozen() const { return frozen; }
 
+  // The returned references only last until the next add. FlatIndex moves its entries when it grows, and the data
+  // vector moves when it regrows, so keep the heap ID rather than the reference
   Indexer& add(gef::StringId nameHash, const Data& item);
   std::pair<Data&, UInt> add(gef::StringId nameHash);
+  void addRange(const gef::StringId* nameHashes, const Data* items, size_t count); // Batched add, growing storage once
+
+  // Removal moves the last item into the hole, so raw heap IDs are only stable between removals. Hold handles across them
+  bool remove(gef::StringId nameHash);
+  bool remove(NamedHeapHandle handle);
+  NamedHeapHandle getHandleByID(UInt id) const { return id < heapedSlots.size() ? NamedHeapHandle{ heapedSlots[id], handleSlots[heapedSlots[id]].generation } : NamedHeapHandle(); }
+  NamedHeapHandle getHandle(gef::StringId nameHash) const { return getHandleByID(getID(nameHash)); }
+  UInt getID(NamedHeapHandle handle) const; // SNULL when stale
+  inline bool isValid(NamedHeapHandle handle) const { return getID(handle) != SNULL; }
+  Data* get(NamedHeapHandle handle) { UInt id = getID(handle); return id == SNULL ? nullptr : &heapedData[id]; }
+  const Data* get(NamedHeapHandle handle) const { UInt id = getID(handle); return id == SNULL ? nullptr : &heapedData[id]; }
 
-  // Where possible use StringId counterparts
+  // Where possible use StringId counterparts. Only adds register the name with the StringTable. Same reference lifetime as above
   Indexer& add(Label name, const Data& item);
   std::pair<Data&, UInt> add(Label name);
+  bool remove(Label name) { return remove(gef::GetStringId(name)); }
   Indexer* getMetaInfo(Label name);
   const Indexer* getMetaInfo(Label name) const;
   UInt getID(Label name) const;
@@ -45,93 +231,636 @@ template<typename Data, typename Indexer = NamedHeapInfo> class NamedHeap
   UInt getID(gef::StringId nameHash) const;
   size_t getHeapSize() const { return heapedData.size(); }
 
-  const std::unordered_map<gef::StringId, Indexer>& getNameMap() const { return metaMap; }
+  gef::StringId getName(UInt id) const { return heapedNames[id]; }
+
+  // Label for the HeapStatsRegistry dump, must outlive the heap. No-op unless instrumented
+  inline void setStatsName(CString label) { stats.setName(label); }
+  inline const Stats& getStats() const { return stats; }
+
+  // Writes names and payload into a relocatable blob, readable in place by NamedHeapView. Requires trivially copyable data
+  bool writeSnapshot(std::vector<Byte>& out) const;
+
+  // Iterates all names as func(gef::StringId, const Indexer&)
+  template<typename Func> void inspectNames(const Func& itFunc) const { frozen ? frozenIndex.inspect(itFunc) : metaIndex.inspect(itFunc); }
 
   private:
-  std::unordered_map<gef::StringId, Indexer> metaMap;
-  std::vector<Data> heapedData;
+  struct HandleSlot
+  {
+    UInt heapID; // SNULL while free
+    UInt generation; // Bumped on every removal
+  };
+
+  UInt link(gef::StringId nameHash); // Books keeping for a fresh item about to be pushed. Returns its heap ID
+  void recordInsert(size_t indexCapacity, size_t dataCapacity); // Capacities from before the insert
+
+  Index<Indexer> metaIndex; // Emptied while frozen
+  PerfectIndex<Indexer> frozenIndex;
+  ArenaVector<Data> heapedData;
+  std::vector<gef::StringId> heapedNames; // Name of each item, to repair the indexer of a moved item
+  std::vector<UInt> heapedSlots; // Handle slot of each item
+  std::vector<HandleSlot> handleSlots;
+  std::vector<UInt> freeSlots;
+  bool frozen;
+  Stats stats;
 };
 
-template<typename Data, typename Indexer>
-inline void NamedHeap<Data, Indexer>::clear()
+// Read-only NamedHeap over a snapshot blob, such as a memory mapped file. Nothing is parsed or copied,
+// so the blob must outlive the view
+template<typename Data> class NamedHeapView
 {
-  heapedData.clear();
-  metaMap.clear();
+  static_assert(std::is_trivially_copyable<Data>::value, "Snapshot data must be trivially copyable");
+
+  public:
+  NamedHeapView() : header{ nullptr }, seeds{ nullptr }, names{ nullptr }, ids{ nullptr }, heapedData{ nullptr } {}
+
+  bool open(const void* blob, size_t size); // Validates the header and the bounds of every section, then binds them
+  void close() { *this = NamedHeapView(); }
+
+  UInt getID(gef::StringId nameHash) const;
+  UInt getID(Label name) const { return getID(gef::GetStringId(name)); }
+  const Data& get(UInt id) const { return heapedData[id]; }
+  inline size_t getHeapSize() const { return header ? header->count : 0; }
+  inline bool isOpen() const { return header != nullptr; }
+
+  private:
+  const NamedHeapSnapshotHeader* header;
+  const UInt* seeds;
+  const gef::StringId* names;
+  const UInt* ids;
+  const Data* heapedData;
+};
+
+// Column-wise counterpart of NamedHeap. Each field lives in its own contiguous array so passes only stream what they touch.
+// Items cannot be removed individually. Index and Stats are the same policies NamedHeap takes, ahead of the fields
+template<template<typename> class Index, typename Stats, typename... Fields> class BasicNamedHeapSoA
+{
+  public:
+  BasicNamedHeapSoA() : frozen{ false } {}
+
+  void clear();
+  void reserve(size_t count);
+
+  void freeze();
+  void thaw();
+  inline bool isFrozen() const { return frozen; }
+
+  UInt add(gef::StringId nameHash, const Fields&... values); // Existing names keep their values
+  UInt add(Label name, const Fields&... values) { return add(StringTable.Add(name), values...); }
+  UInt getID(gef::StringId nameHash) const;
+  UInt getID(Label name) const { return getID(gef::GetStringId(name)); }
+
+  template<size_t Column> auto& get(UInt id) { return std::get<Column>(columns)[id]; }
+  template<size_t Column> const auto& get(UInt id) const { return std::get<Column>(columns)[id]; }
+  template<size_t Column> auto* getColumn() { return std::get<Column>(columns).data(); }
+  template<size_t Column> const auto* getColumn() const { return std::get<Column>(columns).data(); }
+  size_t getHeapSize() const { return std::get<0>(columns).size(); }
+
+  template<typename Func> void inspectNames(const Func& itFunc) const { frozen ? frozenIndex.inspect(itFunc) : metaIndex.inspect(itFunc); }
+
+  inline void setStatsName(CString label) { stats.setName(label); }
+  inline const Stats& getStats() const { return stats; }
+
+  private:
+  template<size_t... Column> void push(std::index_sequence<Column...>, const Fields&... values) { (std::get<Column>(columns).push_back(values), ...); }
+
+  Index<NamedHeapInfo> metaIndex; // Emptied while frozen
+  PerfectIndex<NamedHeapInfo> frozenIndex;
+  std::tuple<std::vector<Fields>...> columns;
+  bool frozen;
+  Stats stats;
+};
+
+template<typename... Fields> using NamedHeapSoA = BasicNamedHeapSoA<FlatIndex, DefaultHeapStats, Fields...>;
+
+template<typename Indexer>
+inline std::pair<Indexer*, bool> MapIndex<Indexer>::insert(gef::StringId nameHash)
+{
+  auto result = nameMap.insert({ nameHash, Indexer() });
+  return { &result.first->second, result.second };
+}
+template<typename Indexer>
+inline Indexer* MapIndex<Indexer>::find(gef::StringId nameHash)
+{
+  auto metaIt = nameMap.find(nameHash);
+  return metaIt == nameMap.end() ? nullptr : &metaIt->second;
+}
+template<typename Indexer>
+inline const Indexer* MapIndex<Indexer>::find(gef::StringId nameHash) const
+{
+  auto metaIt = nameMap.find(nameHash);
+  return metaIt == nameMap.end() ? nullptr : &metaIt->second;
+}
+
+template<typename Indexer>
+inline void FlatIndex<Indexer>::clear()
+{
+  slots.clear();
+  count = 0;
+  shift = 32;
+}
+template<typename Indexer>
+inline void FlatIndex<Indexer>::reserve(size_t minCount)
+{
+  // Keep the load under 3/4
+  size_t capacity = 8;
+  while (capacity * 3 < minCount * 4) { capacity <<= 1; }
+  if (capacity > slots.size()) { rehash(capacity); }
+}
+template<typename Indexer>
+inline std::pair<Indexer*, bool> FlatIndex<Indexer>::insert(gef::StringId nameHash)
+{
+  if (Indexer* existing = find(nameHash)) { return { existing, false }; }
+
+  if ((count + 1) * 4 > slots.size() * 3)
+  {
+    rehash(slots.empty() ? 8 : slots.size() << 1);
+  }
+
+  ++count;
+  return { place({ nameHash, 1, Indexer() }), true };
+}
+template<typename Indexer>
+inline bool FlatIndex<Indexer>::erase(gef::StringId nameHash)
+{
+  UInt idx = locate(nameHash);
+  if (idx == SNULL) { return false; }
+
+  // Backward shift the following cluster so no tombstones are needed
+  const UInt mask = static_cast<UInt>(slots.size() - 1);
+  for (UInt next = (idx + 1) & mask; slots[next].distance > 1; idx = next, next = (next + 1) & mask)
+  {
+    slots[idx] = std::move(slots[next]);
+    --slots[idx].distance;
+  }
+  slots[idx].distance = 0;
+  --count;
+  return true;
+}
+template<typename Indexer>
+inline UInt FlatIndex<Indexer>::locate(gef::StringId nameHash, UInt* probes) const
+{
+  if (probes) { *probes = 0; }
+  if (slots.empty()) { return SNULL; }
+
+  const UInt mask = static_cast<UInt>(slots.size() - 1);
+  UInt idx = home(nameHash);
+  for (UInt distance = 1;; ++distance)
+  {
+    if (probes) { *probes = distance; }
+
+    const Slot& slot = slots[idx];
+    // A richer slot (or an empty one) means the name would have been placed before here
+    if (slot.distance < distance) { return SNULL; }
+    if (slot.nameHash == nameHash) { return idx; }
+    idx = (idx + 1) & mask;
+  }
+}
+template<typename Indexer>
+inline void FlatIndex<Indexer>::rehash(size_t capacity)
+{
+  std::vector<Slot> previous(capacity);
+  previous.swap(slots);
+
+  shift = 32;
+  for (size_t i = capacity; i > 1; i >>= 1) { --shift; }
+
+  for (auto& slot : previous)
+  {
+    if (slot.distance)
+    {
+      slot.distance = 1;
+      place(std::move(slot));
+    }
+  }
+}
+template<typename Indexer>
+inline Indexer* FlatIndex<Indexer>::place(Slot&& incoming)
+{
+  const UInt mask = static_cast<UInt>(slots.size() - 1);
+  Indexer* landed = nullptr;
+  UInt idx = home(incoming.nameHash);
+  for (;; idx = (idx + 1) & mask, ++incoming.distance)
+  {
+    Slot& slot = slots[idx];
+    if (!slot.distance)
+    {
+      slot = std::move(incoming);
+      return landed ? landed : &slot.info;
+    }
+
+    // Steal from the rich, the displaced slot carries on probing
+    if (slot.distance < incoming.distance)
+    {
+      std::swap(slot, incoming);
+      if (!landed) { landed = &slot.info; }
+    }
+  }
+}
+
+template<typename Indexer>
+template<typename Source>
+inline void PerfectIndex<Indexer>::build(const Source& index)
+{
+  std::vector<gef::StringId> names;
+  names.reserve(index.size());
+  index.inspect([&](gef::StringId nameHash, const Indexer&) { names.push_back(nameHash); });
+
+  clear();
+  if (!hash.build(names)) { return; }
+
+  slots.resize(names.size());
+  index.inspect([&](gef::StringId nameHash, const Indexer& info) { slots[hash.slot(nameHash)] = { nameHash, info }; });
 }
 
-template<typename Data, typename Indexer>
-inline Indexer& NamedHeap<Data, Indexer>::add(gef::StringId nameHash, const Data& item)
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline void NamedHeap<Data, Indexer, Index, Stats>::clear()
 {
-  auto& metaIt = this->metaMap.find(nameHash);
-  if (metaIt == this->metaMap.end())
+  heapedData.clear();
+  heapedNames.clear();
+  heapedSlots.clear();
+  metaIndex.clear();
+  frozenIndex.clear();
+  frozen = false;
+
+  // Keep generations so handles from before the clear stay stale
+  freeSlots.clear();
+  for (UInt slot = 0; slot < handleSlots.size(); ++slot)
   {
-    // Register new metadata
-    metaIt = this->metaMap.insert({ nameHash, Indexer() }).first;
+    if (handleSlots[slot].heapID != SNULL)
+    {
+      handleSlots[slot].heapID = SNULL;
+      ++handleSlots[slot].generation;
+    }
+    freeSlots.push_back(slot);
+  }
+}
+
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline void NamedHeap<Data, Indexer, Index, Stats>::reserve(size_t count)
+{
+  heapedData.reserve(count);
+  heapedNames.reserve(count);
+  heapedSlots.reserve(count);
+  if (!frozen) { metaIndex.reserve(count); }
+}
+
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline void NamedHeap<Data, Indexer, Index, Stats>::freeze()
+{
+  if (frozen) { return; }
+
+  frozenIndex.build(metaIndex);
+  if (frozenIndex.size() != metaIndex.size()) { frozenIndex.clear(); return; } // No seeds found, stay mutable
+
+  metaIndex.clear();
+  frozen = true;
+}
+
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline void NamedHeap<Data, Indexer, Index, Stats>::thaw()
+{
+  if (!frozen) { return; }
 
+  metaIndex.reserve(frozenIndex.size());
+  frozenIndex.inspect([&](gef::StringId nameHash, const Indexer& info) { *metaIndex.insert(nameHash).first = info; });
+  frozenIndex.clear();
+  frozen = false;
+}
+
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline Indexer& NamedHeap<Data, Indexer, Index, Stats>::add(gef::StringId nameHash, const Data& item)
+{
+  thaw();
+  const size_t indexCapacity = metaIndex.capacity();
+  auto meta = metaIndex.insert(nameHash);
+  if (meta.second)
+  {
     // Link to a new element
-    metaIt->second.setHeapID(UInt(heapedData.size()));
+    const size_t dataCapacity = heapedData.capacity();
+    meta.first->setHeapID(link(nameHash));
     heapedData.emplace_back(item);
+    recordInsert(indexCapacity, dataCapacity);
   }
 
-  return metaIt->second;
+  return *meta.first;
 }
   
-template<typename Data, typename Indexer>
-inline std::pair<Data&, UInt> NamedHeap<Data, Indexer>::add(gef::StringId nameHash)
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline std::pair<Data&, UInt> NamedHeap<Data, Indexer, Index, Stats>::add(gef::StringId nameHash)
 {
-  auto metaIt = this->metaMap.find(nameHash);
-  if (metaIt == this->metaMap.end())
+  thaw();
+  const size_t indexCapacity = metaIndex.capacity();
+  auto meta = metaIndex.insert(nameHash);
+  if (meta.second)
   {
-    // Register new metadata
-    metaIt = this->metaMap.insert({ nameHash, Indexer() }).first;
-
     // Link to a new element
-    metaIt->second.setHeapID(UInt(heapedData.size()));
+    const size_t dataCapacity = heapedData.capacity();
+    meta.first->setHeapID(link(nameHash));
     heapedData.emplace_back();
+    recordInsert(indexCapacity, dataCapacity);
+  }
+
+  return { heapedData[meta.first->getHeapID()], meta.first->getHeapID() };
+}
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline bool NamedHeap<Data, Indexer, Index, Stats>::writeSnapshot(std::vector<Byte>& out) const
+{
+  static_assert(std::is_trivially_copyable<Data>::value, "Snapshot data must be trivially copyable");
+
+  PerfectHash hash;
+  if (!heapedNames.empty() && !hash.build(std::vector<gef::StringId>(heapedNames.begin(), heapedNames.end()))) { return false; }
+
+  const UInt count = static_cast<UInt>(heapedData.size());
+  auto alignUp = [](UInt offset, UInt alignment) { return (offset + alignment - 1) / alignment * alignment; };
+
+  NamedHeapSnapshotHeader header;
+  header.magic = NamedHeapSnapshotHeader::magicID;
+  header.version = NamedHeapSnapshotHeader::latestVersion;
+  header.count = count;
+  header.stride = static_cast<UInt>(sizeof(Data));
+  header.bucketCount = hash.getBucketCount();
+  header.seedsOffset = alignUp(sizeof(NamedHeapSnapshotHeader), alignof(UInt));
+  header.namesOffset = header.seedsOffset + header.bucketCount * sizeof(UInt);
+  header.idsOffset = header.namesOffset + count * sizeof(gef::StringId);
+  header.dataOffset = alignUp(header.idsOffset + count * sizeof(UInt), static_cast<UInt>(alignof(Data) > 8 ? alignof(Data) : 8));
+  header.totalSize = header.dataOffset + count * sizeof(Data);
+
+  out.assign(header.totalSize, 0);
+  Byte* blob = out.data();
+  std::memcpy(blob, &header, sizeof(header));
+  if (!count) { return true; }
+
+  std::memcpy(blob + header.seedsOffset, hash.getSeeds(), header.bucketCount * sizeof(UInt));
+  gef::StringId* names = reinterpret_cast<gef::StringId*>(blob + header.namesOffset);
+  UInt* ids = reinterpret_cast<UInt*>(blob + header.idsOffset);
+  for (UInt id = 0; id < count; ++id)
+  {
+    UInt slot = hash.slot(heapedNames[id]);
+    names[slot] = heapedNames[id];
+    ids[slot] = id;
+  }
+  std::memcpy(blob + header.dataOffset, heapedData.data(), count * sizeof(Data));
+
+  return true;
+}
+
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline void NamedHeap<Data, Indexer, Index, Stats>::addRange(const gef::StringId* nameHashes, const Data* items, size_t count)
+{
+  thaw();
+  reserve(heapedData.size() + count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    add(nameHashes[i], items[i]);
+  }
+}
+
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline bool NamedHeap<Data, Indexer, Index, Stats>::remove(gef::StringId nameHash)
+{
+  thaw();
+
+  Indexer* meta = metaIndex.find(nameHash);
+  if (!meta) { return false; }
+  UInt id = meta->getHeapID();
+  metaIndex.erase(nameHash);
+
+  // Retire the handle
+  HandleSlot& retired = handleSlots[heapedSlots[id]];
+  retired.heapID = SNULL;
+  ++retired.generation;
+  freeSlots.push_back(heapedSlots[id]);
+
+  // Swap and pop to keep the data contiguous
+  UInt lastID = static_cast<UInt>(heapedData.size() - 1);
+  if (id != lastID)
+  {
+    heapedData[id] = std::move(heapedData[lastID]);
+    heapedNames[id] = heapedNames[lastID];
+    heapedSlots[id] = heapedSlots[lastID];
+
+    handleSlots[heapedSlots[id]].heapID = id;
+    metaIndex.find(heapedNames[id])->setHeapID(id);
   }
+  heapedData.pop_back();
+  heapedNames.pop_back();
+  heapedSlots.pop_back();
+
+  return true;
+}
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline bool NamedHeap<Data, Indexer, Index, Stats>::remove(NamedHeapHandle handle)
+{
+  UInt id = getID(handle);
+  return id != SNULL && remove(heapedNames[id]);
+}
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline UInt NamedHeap<Data, Indexer, Index, Stats>::getID(NamedHeapHandle handle) const
+{
+  if (handle.slot >= handleSlots.size()) { return SNULL; }
 
-  return { heapedData[metaIt->second.getHeapID()], metaIt->second.getHeapID() };
+  const HandleSlot& slot = handleSlots[handle.slot];
+  return slot.generation == handle.generation ? slot.heapID : SNULL;
+}
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline UInt NamedHeap<Data, Indexer, Index, Stats>::link(gef::StringId nameHash)
+{
+  UInt id = static_cast<UInt>(heapedData.size());
+
+  UInt slot;
+  if (freeSlots.empty())
+  {
+    slot = static_cast<UInt>(handleSlots.size());
+    handleSlots.push_back({ SNULL, 0 });
+  }
+  else
+  {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  }
+  handleSlots[slot].heapID = id;
+
+  heapedNames.push_back(nameHash);
+  heapedSlots.push_back(slot);
+  return id;
+}
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline void NamedHeap<Data, Indexer, Index, Stats>::recordInsert(size_t indexCapacity, size_t dataCapacity)
+{
+  if constexpr (Stats::enabled)
+  {
+    stats.recordInsert();
+    if (metaIndex.capacity() != indexCapacity) { stats.recordRehash(); }
+    if (heapedData.capacity() != dataCapacity) { stats.recordReallocation(); }
+  }
 }
-template<typename Data, typename Indexer>
-inline Indexer& NamedHeap<Data, Indexer>::add(Label name, const Data& item)
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline Indexer& NamedHeap<Data, Indexer, Index, Stats>::add(Label name, const Data& item)
 {
   return this->add(StringTable.Add(name), item);
 }
-template<typename Data, typename Indexer>
-inline std::pair<Data&, UInt> NamedHeap<Data, Indexer>::add(Label name)
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline std::pair<Data&, UInt> NamedHeap<Data, Indexer, Index, Stats>::add(Label name)
 {
   return this->add(StringTable.Add(name));
 }
-template<typename Data, typename Indexer>
-inline Indexer* NamedHeap<Data, Indexer>::getMetaInfo(Label name)
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline Indexer* NamedHeap<Data, Indexer, Index, Stats>::getMetaInfo(Label name)
 {
-  return getMetaInfo(StringTable.Add(name));
+  return getMetaInfo(gef::GetStringId(name));
 }
-template<typename Data, typename Indexer>
-inline const Indexer* NamedHeap<Data, Indexer>::getMetaInfo(Label name) const
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline const Indexer* NamedHeap<Data, Indexer, Index, Stats>::getMetaInfo(Label name) const
 {
-  return getMetaInfo(StringTable.Add(name));
+  return getMetaInfo(gef::GetStringId(name));
 }
-template<typename Data, typename Indexer>
-inline UInt NamedHeap<Data, Indexer>::getID(Label name) const
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline UInt NamedHeap<Data, Indexer, Index, Stats>::getID(Label name) const
 {
-  return getID(StringTable.Add(name));
+  return getID(gef::GetStringId(name));
 }
-template<typename Data, typename Indexer>
-inline Indexer* NamedHeap<Data, Indexer>::getMetaInfo(gef::StringId nameHash)
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline Indexer* NamedHeap<Data, Indexer, Index, Stats>::getMetaInfo(gef::StringId nameHash)
 {
-  auto& metaIt = this->metaMap.find(nameHash);
-  return metaIt == this->metaMap.end() ? nullptr : &metaIt->second;
+  return const_cast<Indexer*>(static_cast<const NamedHeap*>(this)->getMetaInfo(nameHash));
 }
-template<typename Data, typename Indexer>
-inline const Indexer* NamedHeap<Data, Indexer>::getMetaInfo(gef::StringId nameHash) const
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline const Indexer* NamedHeap<Data, Indexer, Index, Stats>::getMetaInfo(gef::StringId nameHash) const
 {
-  auto& metaIt = this->metaMap.find(nameHash);
-  return metaIt == this->metaMap.end() ? nullptr : &metaIt->second;
+  if constexpr (Stats::enabled)
+  {
+    UInt probes;
+    const Indexer* meta = frozen ? frozenIndex.find(nameHash, probes) : metaIndex.find(nameHash, probes);
+    stats.recordLookup(meta != nullptr, probes);
+    return meta;
+  }
+  else
+  {
+    return frozen ? frozenIndex.find(nameHash) : metaIndex.find(nameHash);
+  }
 }
-template<typename Data, typename Indexer>
-inline UInt NamedHeap<Data, Indexer>::getID(gef::StringId nameHash) const
+template<typename Data, typename Indexer, template<typename> class Index, typename Stats>
+inline UInt NamedHeap<Data, Indexer, Index, Stats>::getID(gef::StringId nameHash) const
 {
-  auto& metaIt = this->metaMap.find(nameHash);
-  return metaIt == this->metaMap.end() ? SNULL : metaIt->second.getHeapID();
+  auto meta = getMetaInfo(nameHash);
+  return meta ? meta->getHeapID() : SNULL;
+}
+
+template<template<typename> class Index, typename Stats, typename... Fields>
+inline void BasicNamedHeapSoA<Index, Stats, Fields...>::clear()
+{
+  std::apply([](auto&... column) { (column.clear(), ...); }, columns);
+  metaIndex.clear();
+  frozenIndex.clear();
+  frozen = false;
+}
+template<template<typename> class Index, typename Stats, typename... Fields>
+inline void BasicNamedHeapSoA<Index, Stats, Fields...>::reserve(size_t count)
+{
+  std::apply([count](auto&... column) { (column.reserve(count), ...); }, columns);
+  if (!frozen) { metaIndex.reserve(count); }
+}
+template<template<typename> class Index, typename Stats, typename... Fields>
+inline void BasicNamedHeapSoA<Index, Stats, Fields...>::freeze()
+{
+  if (frozen) { return; }
+
+  frozenIndex.build(metaIndex);
+  if (frozenIndex.size() != metaIndex.size()) { frozenIndex.clear(); return; }
+
+  metaIndex.clear();
+  frozen = true;
+}
+template<template<typename> class Index, typename Stats, typename... Fields>
+inline void BasicNamedHeapSoA<Index, Stats, Fields...>::thaw()
+{
+  if (!frozen) { return; }
+
+  metaIndex.reserve(frozenIndex.size());
+  frozenIndex.inspect([&](gef::StringId nameHash, const NamedHeapInfo& info) { *metaIndex.insert(nameHash).first = info; });
+  frozenIndex.clear();
+  frozen = false;
+}
+template<template<typename> class Index, typename Stats, typename... Fields>
+inline UInt BasicNamedHeapSoA<Index, Stats, Fields...>::add(gef::StringId nameHash, const Fields&... values)
+{
+  thaw();
+
+  const size_t indexCapacity = metaIndex.capacity();
+  auto meta = metaIndex.insert(nameHash);
+  if (meta.second)
+  {
+    const size_t dataCapacity = std::get<0>(columns).capacity();
+    meta.first->setHeapID(static_cast<UInt>(getHeapSize()));
+    push(std::index_sequence_for<Fields...>(), values...);
+
+    if constexpr (Stats::enabled)
+    {
+      stats.recordInsert();
+      if (metaIndex.capacity() != indexCapacity) { stats.recordRehash(); }
+      if (std::get<0>(columns).capacity() != dataCapacity) { stats.recordReallocation(); }
+    }
+  }
+  return meta.first->getHeapID();
+}
+template<template<typename> class Index, typename Stats, typename... Fields>
+inline UInt BasicNamedHeapSoA<Index, Stats, Fields...>::getID(gef::StringId nameHash) const
+{
+  const NamedHeapInfo* meta;
+  if constexpr (Stats::enabled)
+  {
+    UInt probes;
+    meta = frozen ? frozenIndex.find(nameHash, probes) : metaIndex.find(nameHash, probes);
+    stats.recordLookup(meta != nullptr, probes);
+  }
+  else
+  {
+    meta = frozen ? frozenIndex.find(nameHash) : metaIndex.find(nameHash);
+  }
+  return meta ? meta->getHeapID() : SNULL;
+}
+
+template<typename Data>
+inline bool NamedHeapView<Data>::open(const void* blob, size_t size)
+{
+  close();
+
+  auto snapshot = static_cast<const NamedHeapSnapshotHeader*>(blob);
+  if (!blob || size < sizeof(NamedHeapSnapshotHeader) || reinterpret_cast<uintptr_t>(blob) % alignof(NamedHeapSnapshotHeader)) { return false; }
+  if (snapshot->magic != NamedHeapSnapshotHeader::magicID || snapshot->version != NamedHeapSnapshotHeader::latestVersion) { return false; }
+  if (snapshot->stride != sizeof(Data) || snapshot->totalSize > size) { return false; }
+  if (snapshot->count && !snapshot->bucketCount) { return false; }
+
+  // Offsets and counts come straight from the file, so every section must be aligned and end within the blob
+  const Byte* base = static_cast<const Byte*>(blob);
+  auto sectionFits = [&](UInt offset, UInt length, size_t elementSize, size_t alignment)
+  {
+    return reinterpret_cast<uintptr_t>(base + offset) % alignment == 0 && uint64_t(offset) + uint64_t(length) * elementSize <= snapshot->totalSize;
+  };
+  if (!sectionFits(snapshot->seedsOffset, snapshot->bucketCount, sizeof(UInt), alignof(UInt)) ||
+      !sectionFits(snapshot->namesOffset, snapshot->count, sizeof(gef::StringId), alignof(gef::StringId)) ||
+      !sectionFits(snapshot->idsOffset, snapshot->count, sizeof(UInt), alignof(UInt)) ||
+      !sectionFits(snapshot->dataOffset, snapshot->count, sizeof(Data), alignof(Data))) { return false; }
+
+  // IDs index the data, so one out of range would let get read past it
+  const UInt* snapshotIDs = reinterpret_cast<const UInt*>(base + snapshot->idsOffset);
+  for (UInt slot = 0; slot < snapshot->count; ++slot)
+  {
+    if (snapshotIDs[slot] >= snapshot->count) { return false; }
+  }
+
+  header = snapshot;
+  seeds = reinterpret_cast<const UInt*>(base + snapshot->seedsOffset);
+  names = reinterpret_cast<const gef::StringId*>(base + snapshot->namesOffset);
+  ids = reinterpret_cast<const UInt*>(base + snapshot->idsOffset);
+  heapedData = reinterpret_cast<const Data*>(base + snapshot->dataOffset);
+  return true;
+}
+template<typename Data>
+inline UInt NamedHeapView<Data>::getID(gef::StringId nameHash) const
+{
+  if (!header || !header->count) { return SNULL; }
+
+  UInt slot = PerfectHash::slot(nameHash, seeds, header->bucketCount, header->count);
+  return names[slot] == nameHash ? ids[slot] : SNULL;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ typedef int Int;
 
 // Unsigned types
 typedef unsigned char Byte;
+typedef unsigned short UShort;
 typedef unsigned int UInt;
 static constexpr UInt SNULL = ~0; // Signed null in unsigned type
 
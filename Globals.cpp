@@ -1,3 +1,35 @@
 #include "Globals.h"
 
-gef::StringIdTable StringTable;
\ No newline at end of file
+StringInterner StringTable;
+
+// Compile time names are only useful while they agree with gef::GetStringId, which is the standard CRC32 of the
+// lowercased name. Mixed case, spaces and underscores all have to land on gef's values
+namespace
+{
+  struct KnownStringId
+  {
+    const char* name;
+    size_t length;
+    gef::StringId id;
+  };
+
+  constexpr KnownStringId knownStringIds[] =
+  {
+    { "Output", 6, 0xCCDE149Eu },
+    { "undefined", 9, 0xFEDC304Fu },
+    { "SkeleClip", 9, 0xD9A8C876u },
+    { "CrossFader", 10, 0x2245C51Du },
+    { "Param Name", 10, 0x97A33B2Fu },
+    { "ROOT_Bone", 9, 0x729B0640u }
+  };
+
+  constexpr bool stringHashAgrees()
+  {
+    for (const KnownStringId& known : knownStringIds)
+    {
+      if (StringHash(known.name, known.length) != known.id) { return false; }
+    }
+    return "OUTPUT"_sid == "output"_sid;
+  }
+  static_assert(stringHashAgrees(), "StringHash no longer matches gef::GetStringId");
+}
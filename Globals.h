@@ -2,4 +2,27 @@
 
 #include <system/string_id.h>
 
-extern gef::StringIdTable StringTable;
\ No newline at end of file
+#include "StringInterner.h"
+
+extern StringInterner StringTable; // Safe to use from importer worker threads
+
+// Compile time counterpart of gef::GetStringId (case insensitive CRC32). Hashes without touching the StringTable
+constexpr gef::StringId StringHash(const char* str, size_t length)
+{
+  gef::StringId crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < length; ++i)
+  {
+    char c = str[i];
+    if (c >= 'A' && c <= 'Z') { c += 'a' - 'A'; }
+
+    crc ^= static_cast<unsigned char>(c);
+    for (int bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+// Constant names in code, e.g. "Output"_sid
+constexpr gef::StringId operator""_sid(const char* str, size_t length) { return StringHash(str, length); }
@@ -0,0 +1,115 @@
+#include "HeapStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+HeapStats::HeapStats() : name{ "unnamed" }, lookups{ 0 }, misses{ 0 }, probeTotal{ 0 }, maxProbe{ 0 }, inserts{ 0 }, reallocations{ 0 }, rehashes{ 0 }
+{
+  HeapStatsRegistry::get().add(this);
+}
+
+HeapStats::HeapStats(const HeapStats& other) : HeapStats()
+{
+  name = other.name;
+}
+
+HeapStats& HeapStats::operator=(const HeapStats& other)
+{
+  name = other.name;
+  return *this;
+}
+
+HeapStats::~HeapStats()
+{
+  HeapStatsRegistry::get().remove(this);
+}
+
+HeapStatsSample HeapStats::sample() const
+{
+  HeapStatsSample out;
+  out.name = name;
+  out.lookups = lookups.load(std::memory_order_relaxed);
+  out.misses = misses.load(std::memory_order_relaxed);
+  out.probes = probeTotal.load(std::memory_order_relaxed);
+  out.maxProbe = maxProbe.load(std::memory_order_relaxed);
+  out.inserts = inserts.load(std::memory_order_relaxed);
+  out.reallocations = reallocations.load(std::memory_order_relaxed);
+  out.rehashes = rehashes.load(std::memory_order_relaxed);
+  return out;
+}
+
+void HeapStats::reset()
+{
+  lookups = 0;
+  misses = 0;
+  probeTotal = 0;
+  maxProbe = 0;
+  inserts = 0;
+  reallocations = 0;
+  rehashes = 0;
+}
+
+HeapStatsRegistry& HeapStatsRegistry::get()
+{
+  // Never destroyed, heaps in other statics may unregister during shutdown
+  static HeapStatsRegistry* registry = new HeapStatsRegistry();
+  return *registry;
+}
+
+void HeapStatsRegistry::dump(std::string& out) const
+{
+  // Many heaps share a role (one bone heap per skeleton), so merge by name
+  std::vector<HeapStatsSample> merged;
+  inspect([&](const HeapStatsSample& stats)
+  {
+    auto it = std::find_if(merged.begin(), merged.end(), [&](const HeapStatsSample& other) { return std::strcmp(other.name, stats.name) == 0; });
+    if (it == merged.end())
+    {
+      merged.push_back(stats);
+      return;
+    }
+
+    it->lookups += stats.lookups;
+    it->misses += stats.misses;
+    it->probes += stats.probes;
+    it->maxProbe = std::max(it->maxProbe, stats.maxProbe);
+    it->inserts += stats.inserts;
+    it->reallocations += stats.reallocations;
+    it->rehashes += stats.rehashes;
+  });
+  std::sort(merged.begin(), merged.end(), [](const HeapStatsSample& a, const HeapStatsSample& b) { return a.lookups > b.lookups; });
+
+  char line[256];
+  std::snprintf(line, sizeof(line), "%-24s %12s %10s %10s %9s %10s %8s %8s\n", "heap", "lookups", "misses", "avg probe", "max probe", "inserts", "reallocs", "rehashes");
+  out += line;
+  for (const HeapStatsSample& stats : merged)
+  {
+    double averageProbe = stats.lookups ? static_cast<double>(stats.probes) / stats.lookups : 0.0;
+    std::snprintf(line, sizeof(line), "%-24s %12llu %10llu %10.2f %9u %10llu %8llu %8llu\n", stats.name, stats.lookups, stats.misses, averageProbe, stats.maxProbe, stats.inserts, stats.reallocations, stats.rehashes);
+    out += line;
+  }
+}
+
+void HeapStatsRegistry::reset()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  for (HeapStats* stats : heaps) { stats->reset(); }
+}
+
+void HeapStatsRegistry::add(HeapStats* stats)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  heaps.push_back(stats);
+}
+
+void HeapStatsRegistry::remove(HeapStats* stats)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = std::find(heaps.begin(), heaps.end(), stats);
+  if (it != heaps.end())
+  {
+    *it = heaps.back();
+    heaps.pop_back();
+  }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Defs.h"
+
+// Instrumentation policies for named heaps. Build with NAMED_HEAP_STATS defined to make counting the default,
+// otherwise every record call compiles away
+
+// Default policy, records nothing
+struct NoHeapStats
+{
+  static constexpr bool enabled = false;
+
+  inline void setName(CString) {}
+  inline void recordLookup(bool, UInt) const {}
+  inline void recordInsert() {}
+  inline void recordReallocation() {}
+  inline void recordRehash() {}
+};
+
+// Point in time copy of a heap's counters
+struct HeapStatsSample
+{
+  CString name;
+  unsigned long long lookups;
+  unsigned long long misses;
+  unsigned long long probes; // Slots visited over all lookups
+  UInt maxProbe;
+  unsigned long long inserts;
+  unsigned long long reallocations; // Data storage moved
+  unsigned long long rehashes; // Name index regrown
+};
+
+// Counting policy. Frozen heaps are read from many threads, so counters are relaxed atomics
+class HeapStats
+{
+  public:
+  static constexpr bool enabled = true;
+
+  HeapStats();
+  HeapStats(const HeapStats& other); // Copies start counting from zero under the same name
+  HeapStats& operator=(const HeapStats& other);
+  ~HeapStats();
+
+  inline void setName(CString label) { name = label; }
+  inline void recordLookup(bool hit, UInt probes) const
+  {
+    lookups.fetch_add(1, std::memory_order_relaxed);
+    if (!hit) { misses.fetch_add(1, std::memory_order_relaxed); }
+    probeTotal.fetch_add(probes, std::memory_order_relaxed);
+    if (probes > maxProbe.load(std::memory_order_relaxed)) { maxProbe.store(probes, std::memory_order_relaxed); } // Racy max is fine for a report
+  }
+  inline void recordInsert() { inserts.fetch_add(1, std::memory_order_relaxed); }
+  inline void recordReallocation() { reallocations.fetch_add(1, std::memory_order_relaxed); }
+  inline void recordRehash() { rehashes.fetch_add(1, std::memory_order_relaxed); }
+
+  HeapStatsSample sample() const;
+  void reset();
+
+  private:
+  CString name;
+  mutable std::atomic<unsigned long long> lookups;
+  mutable std::atomic<unsigned long long> misses;
+  mutable std::atomic<unsigned long long> probeTotal;
+  mutable std::atomic<UInt> maxProbe;
+  std::atomic<unsigned long long> inserts;
+  std::atomic<unsigned long long> reallocations;
+  std::atomic<unsigned long long> rehashes;
+};
+
+// Every live HeapStats, so hot or badly colliding heaps can be found together
+class HeapStatsRegistry
+{
+  public:
+  static HeapStatsRegistry& get();
+
+  // Calls func(const HeapStatsSample&) per live heap
+  template<typename Func> void inspect(const Func& itFunc) const
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    for (const HeapStats* stats : heaps) { itFunc(stats->sample()); }
+  }
+  void dump(std::string& out) const; // One line per heap, merged by name
+  void reset();
+
+  private:
+  friend class HeapStats;
+  HeapStatsRegistry() = default;
+
+  void add(HeapStats* stats);
+  void remove(HeapStats* stats);
+
+  mutable std::mutex lock;
+  std::vector<HeapStats*> heaps;
+};
+
+#ifdef NAMED_HEAP_STATS
+typedef HeapStats DefaultHeapStats;
+#else
+typedef NoHeapStats DefaultHeapStats;
+#endif
@@ -0,0 +1,80 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data{ nullptr }, size{ 0 }
+#ifdef _WIN32
+  , fileHandle{ nullptr }, mappingHandle{ nullptr }
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(Path path)
+{
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) { return false; }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { CloseHandle(file); return false; }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) { CloseHandle(file); return false; }
+
+  const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) { CloseHandle(mapping); CloseHandle(file); return false; }
+
+  fileHandle = file;
+  mappingHandle = mapping;
+  data = view;
+  size = static_cast<size_t>(fileSize.QuadPart);
+#else
+  int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0) { return false; }
+
+  struct stat fileStat;
+  if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) { ::close(file); return false; }
+
+  void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file); // The mapping keeps its own reference
+  if (view == MAP_FAILED) { return false; }
+
+  data = view;
+  size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (!data) { return; }
+
+#ifdef _WIN32
+  UnmapViewOfFile(data);
+  CloseHandle(mappingHandle);
+  CloseHandle(fileHandle);
+  fileHandle = mappingHandle = nullptr;
+#else
+  munmap(const_cast<void*>(data), size);
+#endif
+
+  data = nullptr;
+  size = 0;
+}
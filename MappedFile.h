@@ -0,0 +1,27 @@
+#pragma once
+#include "Defs.h"
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first touch rather than read up front
+class MappedFile
+{
+  public:
+  MappedFile();
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(Path path);
+  void close();
+
+  inline const void* getData() const { return data; }
+  inline size_t getSize() const { return size; }
+  inline bool isOpen() const { return data != nullptr; }
+
+  private:
+  const void* data;
+  size_t size;
+#ifdef _WIN32
+  void* fileHandle;
+  void* mappingHandle;
+#endif
+};
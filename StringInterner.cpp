@@ -0,0 +1,49 @@
+#include "StringInterner.h"
+
+#include <mutex>
+
+gef::StringId StringInterner::Add(Label str)
+{
+  gef::StringId id = gef::GetStringId(str);
+  Shard& shard = getShard(id);
+
+  // Most adds are repeats, so try under the shared lock first
+  {
+    std::shared_lock<std::shared_mutex> readLock(shard.lock);
+    if (shard.names.find(id) != shard.names.end()) { return id; }
+  }
+
+  std::unique_lock<std::shared_mutex> writeLock(shard.lock);
+  shard.names.emplace(id, str); // No-op if another thread got here first
+  return id;
+}
+
+bool StringInterner::Find(gef::StringId id, std::string& out) const
+{
+  if (CString str = Find(id))
+  {
+    out = str;
+    return true;
+  }
+  return false;
+}
+
+CString StringInterner::Find(gef::StringId id) const
+{
+  const Shard& shard = getShard(id);
+  std::shared_lock<std::shared_mutex> readLock(shard.lock);
+
+  auto nameIt = shard.names.find(id);
+  return nameIt == shard.names.end() ? nullptr : nameIt->second.c_str();
+}
+
+size_t StringInterner::size() const
+{
+  size_t count = 0;
+  for (auto& shard : shards)
+  {
+    std::shared_lock<std::shared_mutex> readLock(shard.lock);
+    count += shard.names.size();
+  }
+  return count;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include <system/string_id.h>
+
+#include "Defs.h"
+
+// Thread safe drop-in for gef::StringIdTable. Names are sharded by id, each shard behind its own reader/writer lock
+class StringInterner
+{
+  public:
+  StringInterner() = default;
+  StringInterner(const StringInterner&) = delete;
+  StringInterner& operator=(const StringInterner&) = delete;
+
+  gef::StringId Add(Label str); // Registers a name (first spelling wins) and returns its id
+  bool Find(gef::StringId id, std::string& out) const; // Copies the name out
+  CString Find(gef::StringId id) const; // Non allocating reverse lookup, nullptr when unknown. Valid for the interner's lifetime
+  size_t size() const;
+
+  private:
+  static constexpr size_t shardCount = 16;
+
+  struct alignas(64) Shard // Padded so neighbouring locks do not share a cache line
+  {
+    mutable std::shared_mutex lock;
+    std::unordered_map<gef::StringId, std::string> names; // Node based, so stored strings never move
+  };
+
+  inline Shard& getShard(gef::StringId id) { return shards[id & (shardCount - 1)]; }
+  inline const Shard& getShard(gef::StringId id) const { return shards[id & (shardCount - 1)]; }
+
+  std::array<Shard, shardCount> shards;
+};